@@ -51,6 +51,7 @@ struct window {
     struct renderer r;
     bool closed;
     bool initialized;
+    bool frame_pending;
 };
 
 struct demo {
@@ -344,7 +345,8 @@ window_configure(void *user_data, struct wlf_extent extent)
 
         renderer_init_surface(win->demo, s, &win->r);
         renderer_make_current(win->demo, &win->r);
-        // eglSwapInterval(demo->display, -1);
+        // Frames are paced by surface frame callbacks instead.
+        eglSwapInterval(win->demo->display, 0);
         renderer_init_gears(&win->r);
 
         win->r.view_rot[0] = 20.0f;
@@ -358,6 +360,17 @@ window_configure(void *user_data, struct wlf_extent extent)
     win->r.resized = true;
 }
 
+static void
+window_frame(void *user_data, uint32_t time)
+{
+    struct window *win = user_data;
+    win->frame_pending = false;
+}
+
+static const struct wlf_surface_listener surface_listener = {
+    .frame = window_frame,
+};
+
 static const struct wlf_toplevel_listener toplevel_listener = {
     .close     = window_close,
     .configure = window_configure,
@@ -392,6 +405,7 @@ window_create(struct demo *demo)
         &toplevel_listener,
         &window->toplevel);
     if (res >= WLF_SUCCESS) {
+        wlf_surface_set_listener(wlf_toplevel_get_surface(window->toplevel), &surface_listener);
         return window;
     }
 
@@ -554,12 +568,18 @@ main(int argc, char *argv[])
     int64_t last_time = get_time_ns();
 
     while (!win->closed) {
-        enum wlf_result res = wlf_dispatch_events(demo.context, 0);
+        // Block until the compositor wants the next frame.
+        int64_t timeout = win->frame_pending || !win->initialized ? -1 : 0;
+        enum wlf_result res = wlf_dispatch_events(demo.context, timeout);
         if (res != WLF_SUCCESS) {
             break;
         }
 
-        if (win->initialized) {
+        if (win->initialized && !win->frame_pending) {
+            struct wlf_surface *s = wlf_toplevel_get_surface(win->toplevel);
+            wlf_surface_request_frame(s);
+            win->frame_pending = true;
+
             renderer_make_current(&demo, &win->r);
             renderer_draw(&win->r);
             renderer_present(&demo, &win->r);
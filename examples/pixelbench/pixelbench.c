@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <wayland-client-protocol.h>
+
+#include <wlf/pixel.h>
+
+#define array_len(a) (sizeof(a) / sizeof(a[0]))
+
+static const int32_t WIDTH = 1920;
+static const int32_t HEIGHT = 1080;
+static const int ITERATIONS = 50;
+
+struct format {
+    uint32_t format;
+    const char *name;
+    int32_t bpp;
+};
+
+static const struct format g_formats[] = {
+    { WL_SHM_FORMAT_ARGB8888,    "ARGB8888",    4 },
+    { WL_SHM_FORMAT_XRGB8888,    "XRGB8888",    4 },
+    { WL_SHM_FORMAT_ABGR8888,    "ABGR8888",    4 },
+    { WL_SHM_FORMAT_XBGR8888,    "XBGR8888",    4 },
+    { WL_SHM_FORMAT_RGB565,      "RGB565",      2 },
+    { WL_SHM_FORMAT_ARGB2101010, "ARGB2101010", 4 },
+    { WL_SHM_FORMAT_XRGB2101010, "XRGB2101010", 4 },
+    { WL_SHM_FORMAT_ABGR2101010, "ABGR2101010", 4 },
+    { WL_SHM_FORMAT_XBGR2101010, "XBGR2101010", 4 },
+};
+
+static const enum wlf_pixel_isa g_isas[] = {
+    WLF_PIXEL_ISA_SCALAR,
+    WLF_PIXEL_ISA_SSE2,
+    WLF_PIXEL_ISA_AVX2,
+    WLF_PIXEL_ISA_NEON,
+};
+
+static int64_t
+get_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+}
+
+static struct wlf_pixel_image
+image_create(const struct format *format)
+{
+    struct wlf_pixel_image image = {
+        .stride = WIDTH * format->bpp,
+        .extent = { WIDTH, HEIGHT },
+        .format = format->format,
+    };
+
+    image.data = malloc((size_t)image.stride * HEIGHT);
+    if (!image.data) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t seed = 0x9e3779b9;
+    uint8_t *bytes = image.data;
+    for (size_t i = 0; i < (size_t)image.stride * HEIGHT; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        bytes[i] = (uint8_t)(seed >> 24);
+    }
+    return image;
+}
+
+// Returns throughput in megapixels per second.
+static double
+bench_convert(const struct wlf_pixel_image *dst, const struct wlf_pixel_image *src)
+{
+    wlf_pixel_convert(dst, src, nullptr, 0);
+
+    int64_t start = get_time_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        wlf_pixel_convert(dst, src, nullptr, 0);
+    }
+    int64_t elapsed = get_time_ns() - start;
+
+    return (double)WIDTH * HEIGHT * ITERATIONS / ((double)elapsed / 1e3);
+}
+
+static double
+bench_premultiply(const struct wlf_pixel_image *image)
+{
+    int64_t start = get_time_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        wlf_pixel_premultiply(image, nullptr, 0);
+    }
+    int64_t elapsed = get_time_ns() - start;
+
+    return (double)WIDTH * HEIGHT * ITERATIONS / ((double)elapsed / 1e3);
+}
+
+static double
+bench_fill(const struct wlf_pixel_image *image)
+{
+    int64_t start = get_time_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        wlf_pixel_fill(image, 0xff336699, nullptr, 0);
+    }
+    int64_t elapsed = get_time_ns() - start;
+
+    return (double)WIDTH * HEIGHT * ITERATIONS / ((double)elapsed / 1e3);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct wlf_pixel_image images[array_len(g_formats)];
+    for (size_t i = 0; i < array_len(g_formats); ++i) {
+        images[i] = image_create(&g_formats[i]);
+    }
+
+    printf("%dx%d, %d iterations, MPix/s\n\n", WIDTH, HEIGHT, ITERATIONS);
+
+    for (size_t k = 0; k < array_len(g_isas); ++k) {
+        if (wlf_pixel_set_isa(g_isas[k]) != WLF_SUCCESS) {
+            continue;
+        }
+
+        const char *isa = wlf_pixel_isa_get_name(g_isas[k]);
+
+        for (size_t i = 0; i < array_len(g_formats); ++i) {
+            for (size_t j = 0; j < array_len(g_formats); ++j) {
+                if (i == j) {
+                    continue;
+                }
+                double mpps = bench_convert(&images[j], &images[i]);
+                printf("%-6s convert %-11s -> %-11s %9.1f\n",
+                    isa, g_formats[i].name, g_formats[j].name, mpps);
+            }
+        }
+
+        for (size_t i = 0; i < array_len(g_formats); ++i) {
+            printf("%-6s fill    %-11s %24.1f\n", isa, g_formats[i].name, bench_fill(&images[i]));
+        }
+
+        printf("%-6s premultiply ARGB8888 %21.1f\n\n", isa, bench_premultiply(&images[0]));
+    }
+
+    for (size_t i = 0; i < array_len(g_formats); ++i) {
+        free(images[i].data);
+    }
+    return EXIT_SUCCESS;
+}
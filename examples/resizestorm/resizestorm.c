@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <wayland-client-protocol.h>
+
+#include <wlf/context.h>
+#include <wlf/surface.h>
+#include <wlf/toplevel.h>
+#include <wlf/shm.h>
+#include <wlf/pixel.h>
+
+// Resize the window interactively, or pass a count to have the demo toggle
+// maximization that many times per frame. Every configure reallocates the
+// buffers, so the reported reallocations per frame should stay at one or
+// below however many configures the compositor sends.
+
+struct window {
+    struct wlf_context *context;
+    struct wlf_toplevel *toplevel;
+    struct wlf_shm_pool *pool;
+    struct wlf_extent extent;
+
+    bool closed;
+    bool configured;
+    bool frame_pending;
+    bool maximized;
+    uint32_t color;
+
+    uint32_t frames;
+    uint32_t reallocations;
+};
+
+static int64_t
+get_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+}
+
+static void
+on_seat(void *data, uint64_t id, bool added)
+{
+}
+
+static const struct wlf_context_listener context_listener = {
+    .seat = on_seat,
+};
+
+static void
+window_close(void *user_data)
+{
+    struct window *win = user_data;
+    win->closed = true;
+}
+
+static void
+window_configure(void *user_data, struct wlf_extent extent)
+{
+    struct window *win = user_data;
+    win->extent = extent;
+    win->configured = true;
+
+    // Reallocate on every configure like a renderer recreating its swapchain.
+    enum wlf_result res;
+    if (win->pool) {
+        res = wlf_shm_pool_resize(win->pool, extent);
+    } else {
+        struct wlf_shm_pool_info info = {
+            .extent       = extent,
+            .format       = WL_SHM_FORMAT_XRGB8888,
+            .buffer_count = 2,
+        };
+        res = wlf_shm_pool_create(win->context, &info, &win->pool);
+    }
+    if (res < WLF_SUCCESS) {
+        fprintf(stderr, "Failed to allocate buffers: %d\n", res);
+        win->closed = true;
+        return;
+    }
+    win->reallocations++;
+}
+
+static void
+window_frame(void *user_data, uint32_t time)
+{
+    struct window *win = user_data;
+    win->frame_pending = false;
+}
+
+static const struct wlf_surface_listener surface_listener = {
+    .frame = window_frame,
+};
+
+static const struct wlf_toplevel_listener toplevel_listener = {
+    .close     = window_close,
+    .configure = window_configure,
+};
+
+static void
+window_draw(struct window *win)
+{
+    struct wlf_shm_buffer *buffer;
+    if (wlf_shm_pool_acquire(win->pool, &buffer) != WLF_SUCCESS) {
+        return;
+    }
+
+    struct wlf_pixel_image image = {
+        .data   = wlf_shm_buffer_get_data(buffer),
+        .stride = wlf_shm_buffer_get_stride(buffer),
+        .extent = wlf_shm_buffer_get_extent(buffer),
+        .format = WL_SHM_FORMAT_XRGB8888,
+    };
+    struct wlf_rect rect = { .extent = image.extent };
+    win->color = (win->color + 0x010203) & 0xffffff;
+    wlf_pixel_fill(&image, 0xff000000 | win->color, &rect, 1);
+
+    struct wlf_surface *s = wlf_toplevel_get_surface(win->toplevel);
+    wlf_surface_request_frame(s);
+    wlf_surface_attach_shm_buffer(s, buffer);
+    wlf_surface_commit(s);
+
+    win->frame_pending = true;
+    win->frames++;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int storm = argc > 1 ? atoi(argv[1]) : 0;
+
+    struct window win = {};
+
+    struct wlf_context_info context_info = {
+        .flags = WLF_CONTEXT_FLAGS_NONE,
+    };
+    enum wlf_result res = wlf_context_create(&context_info, &context_listener, &win.context);
+    if (res != WLF_SUCCESS) {
+        fprintf(stderr, "wlf_context_create failed: %d\n", res);
+        return EXIT_FAILURE;
+    }
+
+    const char8_t title[] = u8"resizestorm";
+    const char8_t app_id[] = u8"wleaf.resizestorm";
+
+    struct wlf_toplevel_info info = {
+        .flags     = WLF_TOPLEVEL_FLAGS_DEFERRED_ACK,
+        .extent    = { 640, 360 },
+        .title     = title,
+        .app_id    = app_id,
+        .user_data = &win,
+    };
+    res = wlf_toplevel_create(win.context, &info, &toplevel_listener, &win.toplevel);
+    if (res < WLF_SUCCESS) {
+        fprintf(stderr, "wlf_toplevel_create failed: %d\n", res);
+        wlf_context_destroy(win.context);
+        return EXIT_FAILURE;
+    }
+    wlf_surface_set_listener(wlf_toplevel_get_surface(win.toplevel), &surface_listener);
+
+    int64_t report_time = get_time_ns();
+
+    while (!win.closed) {
+        int64_t timeout = win.frame_pending || !win.configured ? -1 : 0;
+        if (wlf_dispatch_events(win.context, timeout) != WLF_SUCCESS) {
+            break;
+        }
+
+        if (win.configured && !win.frame_pending && win.pool) {
+            for (int i = 0; i < storm; ++i) {
+                win.maximized = !win.maximized;
+                wlf_toplevel_set_maximized(win.toplevel, win.maximized);
+            }
+            window_draw(&win);
+        }
+
+        int64_t now = get_time_ns();
+        if (now - report_time >= 1000000000) {
+            double per_frame = win.frames ? (double)win.reallocations / win.frames : 0.0;
+            printf("%4dx%-4d %4u frames %5u reallocations %.2f per frame\n",
+                win.extent.width, win.extent.height,
+                win.frames, win.reallocations, per_frame);
+            win.frames = 0;
+            win.reallocations = 0;
+            report_time = now;
+        }
+    }
+
+    if (win.pool) {
+        wlf_shm_pool_destroy(win.pool);
+    }
+    wlf_toplevel_destroy(win.toplevel);
+    wlf_context_destroy(win.context);
+    return EXIT_SUCCESS;
+}
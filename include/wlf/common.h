@@ -8,11 +8,13 @@ struct wlf_seat;
 struct wlf_surface;
 struct wlf_toplevel;
 struct wlf_popup;
+struct wlf_dmabuf_feedback;
 
 enum wlf_result : int32_t {
     WLF_SUCCESS = 0,
     WLF_ALREADY_SET = 1,
     WLF_SKIPPED = 2,
+    WLF_PENDING = 3,
     WLF_ERROR_UNKNOWN = -1,
     WLF_ERROR_OUT_OF_MEMORY = -2,
     WLF_ERROR_UNSUPPORTED = -3,
@@ -42,6 +44,13 @@ struct wlf_point {
     double y;
 };
 
+struct wlf_color {
+    float r;
+    float g;
+    float b;
+    float a;
+};
+
 enum wlf_edge : uint32_t {
     WLF_EDGE_NONE = 0,
     WLF_EDGE_TOP = 1,
@@ -4,15 +4,53 @@
 
 struct wlf_context_listener {
     void (*seat)(void *user_data, uint64_t id, bool added);
+    void (*ready)(void *user_data, enum wlf_result result);
+    void (*dmabuf_feedback)(void *user_data, const struct wlf_dmabuf_feedback *feedback);
 };
 
 enum wlf_context_flags : uint32_t {
     WLF_CONTEXT_FLAGS_NONE = 0,
     // WLF_CONTEXT_FLAGS_DBUS = 1,
+    WLF_CONTEXT_FLAGS_SELECT_FEATURES = 2,
+    WLF_CONTEXT_FLAGS_ASYNC = 4,
+    WLF_CONTEXT_FLAGS_LOG_TIMING = 8,
+};
+
+enum wlf_feature : uint32_t {
+    WLF_FEATURE_NONE = 0,
+    WLF_FEATURE_DATA_DEVICE = 1,
+    WLF_FEATURE_VIEWPORTER = 2,
+    WLF_FEATURE_FRACTIONAL_SCALE = 4,
+    WLF_FEATURE_SINGLE_PIXEL_BUFFER = 8,
+    WLF_FEATURE_CONTENT_TYPE = 16,
+    WLF_FEATURE_ALPHA_MODIFIER = 32,
+    WLF_FEATURE_IDLE_INHIBIT = 64,
+    WLF_FEATURE_IDLE_NOTIFY = 128,
+    WLF_FEATURE_INPUT_TIMESTAMPS = 256,
+    WLF_FEATURE_RELATIVE_POINTER = 512,
+    WLF_FEATURE_POINTER_CONSTRAINTS = 1024,
+    WLF_FEATURE_POINTER_GESTURES = 2048,
+    WLF_FEATURE_KEYBOARD_SHORTCUTS_INHIBIT = 4096,
+    WLF_FEATURE_TEXT_INPUT = 8192,
+    WLF_FEATURE_DECORATION = 16384,
+    WLF_FEATURE_DIALOG = 32768,
+    WLF_FEATURE_XDG_OUTPUT = 65536,
+    WLF_FEATURE_PRESENTATION = 131072,
+    WLF_FEATURE_TEARING_CONTROL = 262144,
+    WLF_FEATURE_FIFO = 524288,
+    WLF_FEATURE_COMMIT_TIMING = 1048576,
+    WLF_FEATURE_LINUX_DMABUF = 2097152,
+};
+
+struct wlf_flush_stats {
+    uint64_t eagain_count;
+    uint32_t queued_bytes;
+    bool pending;
 };
 
 struct wlf_context_info {
     enum wlf_context_flags flags;
+    enum wlf_feature features;
     const char *display;
     void *user_data;
 };
@@ -26,5 +64,38 @@ wlf_context_create(
 void
 wlf_context_destroy(struct wlf_context *context);
 
+bool
+wlf_context_is_ready(struct wlf_context *context);
+
+enum wlf_feature
+wlf_context_get_features(struct wlf_context *context);
+
+int64_t
+wlf_context_get_presentation_time(struct wlf_context *context);
+
 enum wlf_result
 wlf_dispatch_events(struct wlf_context *context, int64_t timeout);
+
+enum wlf_result
+wlf_context_wakeup(struct wlf_context *context);
+
+int
+wlf_context_get_fd(struct wlf_context *context);
+
+enum wlf_result
+wlf_context_prepare(struct wlf_context *context);
+
+enum wlf_result
+wlf_context_flush(struct wlf_context *context);
+
+enum wlf_result
+wlf_context_get_flush_stats(struct wlf_context *context, struct wlf_flush_stats *stats);
+
+enum wlf_result
+wlf_context_read(struct wlf_context *context);
+
+void
+wlf_context_cancel_read(struct wlf_context *context);
+
+enum wlf_result
+wlf_context_dispatch_pending(struct wlf_context *context);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common.h"
+
+struct wlf_dmabuf_buffer;
+
+enum wlf_dmabuf_tranche_flags : uint32_t {
+    WLF_DMABUF_TRANCHE_FLAGS_NONE = 0,
+    WLF_DMABUF_TRANCHE_FLAGS_SCANOUT = 1,
+};
+
+struct wlf_dmabuf_format {
+    uint32_t format;
+    uint32_t padding;
+    uint64_t modifier;
+};
+
+struct wlf_dmabuf_tranche {
+    uint64_t device;
+    enum wlf_dmabuf_tranche_flags flags;
+    const uint16_t *indices;
+    uint32_t index_count;
+};
+
+struct wlf_dmabuf_feedback {
+    uint64_t main_device;
+    const struct wlf_dmabuf_format *formats;
+    uint32_t format_count;
+    const struct wlf_dmabuf_tranche *tranches;
+    uint32_t tranche_count;
+};
+
+struct wlf_dmabuf_plane {
+    int fd;
+    uint32_t offset;
+    uint32_t stride;
+};
+
+struct wlf_dmabuf_attributes {
+    struct wlf_extent extent;
+    uint32_t format;
+    uint64_t modifier;
+    uint32_t plane_count;
+    struct wlf_dmabuf_plane planes[4];
+};
+
+enum wlf_result
+wlf_context_get_dmabuf_feedback(struct wlf_context *context, const struct wlf_dmabuf_feedback **feedback);
+
+enum wlf_result
+wlf_surface_get_dmabuf_feedback(struct wlf_surface *surface, const struct wlf_dmabuf_feedback **feedback);
+
+enum wlf_result
+wlf_dmabuf_buffer_create(
+    struct wlf_context *context,
+    const struct wlf_dmabuf_attributes *attributes,
+    struct wlf_dmabuf_buffer **buffer);
+
+void
+wlf_dmabuf_buffer_destroy(struct wlf_dmabuf_buffer *buffer);
+
+bool
+wlf_dmabuf_buffer_is_busy(struct wlf_dmabuf_buffer *buffer);
+
+enum wlf_result
+wlf_surface_attach_dmabuf_buffer(struct wlf_surface *surface, struct wlf_dmabuf_buffer *buffer);
@@ -12,6 +12,21 @@ wlfCreateEGLSurface(
     struct wlf_surface *surface,
     EGLConfig config);
 
+EGLBoolean
+wlfSwapEGLBuffersAt(
+    PFNEGLSWAPBUFFERSPROC proc,
+    EGLDisplay display,
+    struct wlf_surface *surface,
+    EGLSurface egl_surface,
+    int64_t present_time);
+
+EGLBoolean
+wlfSwapEGLBuffersWithDamage(
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC proc,
+    EGLDisplay display,
+    struct wlf_surface *surface,
+    EGLSurface egl_surface);
+
 void
 wlfDestroyEGLSurface(
     PFNEGLDESTROYSURFACEPROC proc,
@@ -67,6 +67,7 @@ struct wlf_seat_listener {
     void (*name)(void *user_data, const char8_t *name);
     void (*idled)(void *user_data, bool idled);
     void (*shortcuts_inhibited)(void *user_data, struct wlf_surface *surface, bool inhibited);
+    void (*key)(void *user_data, struct wlf_surface *surface, uint32_t keysym, enum wlf_key_state state);
 };
 
 struct wlf_seat_info {
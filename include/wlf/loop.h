@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.h"
+
+struct wlf_source;
+
+enum wlf_source_events : uint32_t {
+    WLF_SOURCE_EVENTS_NONE = 0,
+    WLF_SOURCE_EVENTS_READABLE = 1,
+    WLF_SOURCE_EVENTS_WRITABLE = 2,
+    WLF_SOURCE_EVENTS_HANGUP = 4,
+    WLF_SOURCE_EVENTS_ERROR = 8,
+};
+
+typedef void (*wlf_fd_func_t)(void *user_data, int fd, enum wlf_source_events events);
+
+typedef void (*wlf_timer_func_t)(void *user_data);
+
+enum wlf_result
+wlf_context_add_fd(
+    struct wlf_context *context,
+    int fd,
+    enum wlf_source_events events,
+    wlf_fd_func_t func,
+    void *user_data,
+    struct wlf_source **source);
+
+enum wlf_result
+wlf_context_add_timer(
+    struct wlf_context *context,
+    wlf_timer_func_t func,
+    void *user_data,
+    struct wlf_source **source);
+
+int
+wlf_context_get_loop_fd(struct wlf_context *context);
+
+enum wlf_result
+wlf_context_dispatch_sources(struct wlf_context *context);
+
+enum wlf_result
+wlf_source_set_events(struct wlf_source *source, enum wlf_source_events events);
+
+enum wlf_result
+wlf_source_arm_timer(struct wlf_source *source, int64_t delay, int64_t interval);
+
+void
+wlf_source_remove(struct wlf_source *source);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.h"
+
+enum wlf_pixel_isa : uint32_t {
+    WLF_PIXEL_ISA_SCALAR = 0,
+    WLF_PIXEL_ISA_SSE2 = 1,
+    WLF_PIXEL_ISA_AVX2 = 2,
+    WLF_PIXEL_ISA_NEON = 3,
+};
+
+struct wlf_pixel_image {
+    void *data;
+    int32_t stride;
+    struct wlf_extent extent;
+    uint32_t format;
+};
+
+bool
+wlf_pixel_format_supported(uint32_t format);
+
+enum wlf_pixel_isa
+wlf_pixel_get_isa(void);
+
+enum wlf_result
+wlf_pixel_set_isa(enum wlf_pixel_isa isa);
+
+const char *
+wlf_pixel_isa_get_name(enum wlf_pixel_isa isa);
+
+enum wlf_result
+wlf_pixel_convert(
+    const struct wlf_pixel_image *dst,
+    const struct wlf_pixel_image *src,
+    const struct wlf_rect *rects,
+    uint32_t rect_count);
+
+enum wlf_result
+wlf_pixel_premultiply(
+    const struct wlf_pixel_image *image,
+    const struct wlf_rect *rects,
+    uint32_t rect_count);
+
+enum wlf_result
+wlf_pixel_fill(
+    const struct wlf_pixel_image *image,
+    uint32_t argb,
+    const struct wlf_rect *rects,
+    uint32_t rect_count);
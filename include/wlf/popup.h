@@ -13,6 +13,9 @@ enum wlf_popup_flags : uint32_t {
     WLF_POPUP_FLAGS_NONE = 0,
     WLF_POPUP_FLAGS_REACTIVE = 1,
     WLF_POPUP_FLAGS_INHIBIT_IDLING = 2,
+    WLF_POPUP_FLAGS_EVENT_QUEUE = 4,
+    WLF_POPUP_FLAGS_DEFERRED_ACK = 8,
+    WLF_POPUP_FLAGS_FIFO = 16,
 };
 
 struct wlf_popup_position {
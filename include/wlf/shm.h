@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common.h"
+
+struct wlf_shm_pool;
+struct wlf_shm_buffer;
+
+struct wlf_shm_pool_info {
+    struct wlf_extent extent;
+    uint32_t format;
+    uint32_t buffer_count;
+};
+
+bool
+wlf_context_has_shm_format(struct wlf_context *context, uint32_t format);
+
+enum wlf_result
+wlf_shm_pool_create(
+    struct wlf_context *context,
+    const struct wlf_shm_pool_info *info,
+    struct wlf_shm_pool **pool);
+
+void
+wlf_shm_pool_destroy(struct wlf_shm_pool *pool);
+
+enum wlf_result
+wlf_shm_pool_resize(struct wlf_shm_pool *pool, struct wlf_extent extent);
+
+enum wlf_result
+wlf_shm_pool_acquire(struct wlf_shm_pool *pool, struct wlf_shm_buffer **buffer);
+
+void
+wlf_shm_buffer_discard(struct wlf_shm_buffer *buffer);
+
+void *
+wlf_shm_buffer_get_data(struct wlf_shm_buffer *buffer);
+
+int32_t
+wlf_shm_buffer_get_stride(struct wlf_shm_buffer *buffer);
+
+struct wlf_extent
+wlf_shm_buffer_get_extent(struct wlf_shm_buffer *buffer);
+
+enum wlf_result
+wlf_surface_attach_shm_buffer(struct wlf_surface *surface, struct wlf_shm_buffer *buffer);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.h"
+
+struct wlf_subsurface;
+
+struct wlf_subsurface_listener {
+    void (*configure)(void *user_data, struct wlf_extent extent);
+};
+
+enum wlf_subsurface_flags : uint32_t {
+    WLF_SUBSURFACE_FLAGS_NONE = 0,
+    WLF_SUBSURFACE_FLAGS_DESYNC = 1,
+    WLF_SUBSURFACE_FLAGS_EVENT_QUEUE = 2,
+    WLF_SUBSURFACE_FLAGS_FIFO = 4,
+};
+
+struct wlf_subsurface_info {
+    enum wlf_subsurface_flags flags;
+    struct wlf_surface        *parent;
+    struct wlf_offset         position;
+    struct wlf_extent         extent;
+    void                      *user_data;
+};
+
+enum wlf_result
+wlf_subsurface_create(
+    struct wlf_context *context,
+    const struct wlf_subsurface_info *info,
+    const struct wlf_subsurface_listener *listener,
+    struct wlf_subsurface **subsurface);
+
+void
+wlf_subsurface_destroy(struct wlf_subsurface *subsurface);
+
+struct wlf_surface *
+wlf_subsurface_get_surface(struct wlf_subsurface *subsurface);
+
+struct wlf_subsurface *
+wlf_subsurface_from_surface(struct wlf_surface *surface);
+
+struct wlf_extent
+wlf_subsurface_get_buffer_extent(struct wlf_subsurface *subsurface);
+
+void
+wlf_subsurface_set_position(struct wlf_subsurface *subsurface, struct wlf_offset position);
+
+enum wlf_result
+wlf_subsurface_place_above(struct wlf_subsurface *subsurface, struct wlf_surface *sibling);
+
+enum wlf_result
+wlf_subsurface_place_below(struct wlf_subsurface *subsurface, struct wlf_surface *sibling);
+
+void
+wlf_subsurface_set_sync(struct wlf_subsurface *subsurface, bool sync);
+
+enum wlf_result
+wlf_subsurface_set_extent(struct wlf_subsurface *subsurface, struct wlf_extent extent);
+
+enum wlf_result
+wlf_subsurface_set_source(struct wlf_subsurface *subsurface, const struct wlf_rect *rect);
@@ -2,12 +2,92 @@
 
 #include "common.h"
 
+enum wlf_presentation_flags : uint32_t {
+    WLF_PRESENTATION_FLAGS_NONE = 0,
+    WLF_PRESENTATION_FLAGS_VSYNC = 1,
+    WLF_PRESENTATION_FLAGS_HW_CLOCK = 2,
+    WLF_PRESENTATION_FLAGS_HW_COMPLETION = 4,
+    WLF_PRESENTATION_FLAGS_ZERO_COPY = 8,
+};
+
+struct wlf_presentation_feedback {
+    int64_t commit_time;
+    int64_t present_time;
+    int64_t refresh;
+    uint64_t msc;
+    enum wlf_presentation_flags flags;
+};
+
+struct wlf_presentation_stats {
+    uint64_t presented;
+    uint64_t discarded;
+    uint64_t missed;
+    int64_t refresh;
+    int64_t latency_p50;
+    int64_t latency_p90;
+    int64_t latency_p99;
+};
+
+enum wlf_presentation_hint : uint32_t {
+    WLF_PRESENTATION_HINT_VSYNC = 0,
+    WLF_PRESENTATION_HINT_ASYNC = 1,
+};
+
+enum wlf_frame_mode : uint32_t {
+    WLF_FRAME_MODE_CALLBACK = 0,
+    WLF_FRAME_MODE_DEADLINE = 1,
+};
+
+struct wlf_surface_listener {
+    void (*frame)(void *user_data, uint32_t time);
+    void (*presented)(void *user_data, const struct wlf_presentation_feedback *feedback);
+    void (*discarded)(void *user_data);
+    void (*dmabuf_feedback)(void *user_data, const struct wlf_dmabuf_feedback *feedback);
+};
+
 void
 wlf_surface_set_user_data(struct wlf_surface *surface, void *data);
 
 void *
 wlf_surface_get_user_data(struct wlf_surface *surface);
 
+void
+wlf_surface_set_listener(struct wlf_surface *surface, const struct wlf_surface_listener *listener);
+
+enum wlf_result
+wlf_surface_request_frame(struct wlf_surface *surface);
+
+void
+wlf_surface_commit(struct wlf_surface *surface);
+
+void
+wlf_surface_ack_configure(struct wlf_surface *surface);
+
+uint64_t
+wlf_surface_get_primary_output(struct wlf_surface *surface);
+
+enum wlf_result
+wlf_surface_attach_solid_color(struct wlf_surface *surface, struct wlf_color color);
+
+enum wlf_result
+wlf_surface_add_damage(struct wlf_surface *surface, struct wlf_rect rect);
+
+enum wlf_result
+wlf_surface_get_repaint_region(
+    struct wlf_surface *surface,
+    uint32_t buffer_age,
+    struct wlf_rect *rects,
+    uint32_t *count);
+
+enum wlf_result
+wlf_surface_set_frame_mode(struct wlf_surface *surface, enum wlf_frame_mode mode);
+
+enum wlf_result
+wlf_surface_request_feedback(struct wlf_surface *surface);
+
+enum wlf_result
+wlf_surface_get_presentation_stats(struct wlf_surface *surface, struct wlf_presentation_stats *stats);
+
 struct wlf_offset
 wlf_surface_point_to_buffer_offset(struct wlf_surface *surface, struct wlf_point point);
 
@@ -19,3 +99,18 @@ wlf_surface_set_content_type(struct wlf_surface *surface, enum wlf_content_type
 
 enum wlf_result
 wlf_surface_set_alpha_multiplier(struct wlf_surface *surface, uint32_t factor);
+
+enum wlf_result
+wlf_surface_set_presentation_hint(struct wlf_surface *surface, enum wlf_presentation_hint hint);
+
+enum wlf_result
+wlf_surface_set_fifo_barrier(struct wlf_surface *surface);
+
+enum wlf_result
+wlf_surface_wait_fifo_barrier(struct wlf_surface *surface);
+
+enum wlf_result
+wlf_surface_set_present_time(struct wlf_surface *surface, int64_t time);
+
+enum wlf_result
+wlf_surface_dispatch(struct wlf_surface *surface, int64_t timeout);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.h"
+
+enum wlf_timing : uint32_t {
+    WLF_TIMING_CONNECT = 0,
+    WLF_TIMING_REGISTRY = 1,
+    WLF_TIMING_BIND = 2,
+    WLF_TIMING_CURSOR_THEME = 3,
+    WLF_TIMING_KEYMAP = 4,
+    WLF_TIMING_FIRST_CONFIGURE = 5,
+    WLF_TIMING_FIRST_FRAME = 6,
+    WLF_TIMING_COUNT = 7,
+};
+
+enum wlf_counter : uint32_t {
+    WLF_COUNTER_FIRST_FRAME_CONFIGURES = 0,
+    WLF_COUNTER_PREDICTION_HITS = 1,
+    WLF_COUNTER_PREDICTION_MISSES = 2,
+    WLF_COUNTER_COUNT = 3,
+};
+
+struct wlf_timing_span {
+    int64_t start;
+    int64_t duration;
+    uint32_t count;
+};
+
+struct wlf_timing_report {
+    int64_t origin;
+    struct wlf_timing_span spans[WLF_TIMING_COUNT];
+    uint64_t counters[WLF_COUNTER_COUNT];
+};
+
+enum wlf_result
+wlf_context_get_timing_report(struct wlf_context *context, struct wlf_timing_report *report);
+
+const char *
+wlf_timing_get_name(enum wlf_timing timing);
+
+const char *
+wlf_counter_get_name(enum wlf_counter counter);
@@ -11,9 +11,14 @@ enum wlf_toplevel_flags : uint32_t {
     WLF_TOPLEVEL_FLAGS_NONE = 0,
     WLF_TOPLEVEL_FLAGS_DIALOG = 1,
     WLF_TOPLEVEL_FLAGS_INHIBIT_IDLING = 2,
-    // WLF_TOPLEVEL_FLAGS_VIEWPORT_RESIZE = 4,
+    WLF_TOPLEVEL_FLAGS_VIEWPORT_RESIZE = 4,
     // WLF_TOPLEVEL_FLAGS_MAINTAIN_ASPECT_RATIO = 8,
-    // WLF_TOPLEVEL_FLAGS_FIXED_BUFFER_EXTENT = 16,
+    WLF_TOPLEVEL_FLAGS_FIXED_BUFFER_EXTENT = 16,
+    WLF_TOPLEVEL_FLAGS_EVENT_QUEUE = 32,
+    WLF_TOPLEVEL_FLAGS_AUTO_TEARING = 64,
+    WLF_TOPLEVEL_FLAGS_PLACEHOLDER = 128,
+    WLF_TOPLEVEL_FLAGS_DEFERRED_ACK = 256,
+    WLF_TOPLEVEL_FLAGS_FIFO = 512,
 };
 
 enum wlf_decoration_mode : uint32_t {
@@ -31,6 +36,7 @@ struct wlf_toplevel_info {
     const char8_t            *app_id;
     const char8_t            *title;
     bool                     modal;
+    struct wlf_color         placeholder_color;
     void                     *user_data;
 };
 
@@ -50,6 +56,9 @@ wlf_toplevel_get_surface(struct wlf_toplevel *toplevel);
 struct wlf_toplevel *
 wlf_toplevel_from_surface(struct wlf_surface *surface);
 
+struct wlf_extent
+wlf_toplevel_get_predicted_extent(struct wlf_toplevel *toplevel);
+
 void
 wlf_toplevel_set_parent(struct wlf_toplevel *toplevel, struct wlf_toplevel *parent);
 
@@ -88,3 +97,12 @@ wlf_toplevel_set_decoration_mode(struct wlf_toplevel *toplevel, enum wlf_decorat
 
 enum wlf_result
 wlf_toplevel_set_dialog_modal(struct wlf_toplevel *toplevel, bool set);
+
+enum wlf_result
+wlf_toplevel_set_target_frame_time(struct wlf_toplevel *toplevel, int64_t frame_time);
+
+enum wlf_result
+wlf_toplevel_report_frame_time(struct wlf_toplevel *toplevel, int64_t frame_time);
+
+uint32_t
+wlf_toplevel_get_render_scale(struct wlf_toplevel *toplevel);
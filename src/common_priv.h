@@ -1,5 +1,7 @@
 #pragma once
 
+#include <time.h>
+
 #include "wlf/common.h"
 
 [[maybe_unused]]
@@ -52,6 +54,32 @@ wlf_ms_to_ns(uint32_t mtime)
     return ((int64_t)mtime) * 1'000'000;
 }
 
+[[maybe_unused]]
+static inline int64_t
+wlf_get_clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ((int64_t)ts.tv_sec * 1'000'000'000) + (int64_t)ts.tv_nsec;
+}
+
+[[maybe_unused]]
+static inline int64_t
+wlf_get_time_ns(void)
+{
+    return wlf_get_clock_ns(CLOCK_MONOTONIC);
+}
+
+[[maybe_unused]]
+static inline struct timespec
+wlf_ns_to_timespec(int64_t ns)
+{
+    return (struct timespec) {
+        .tv_sec = (time_t)(ns / 1'000'000'000),
+        .tv_nsec = (long)(ns % 1'000'000'000),
+    };
+}
+
 static inline bool
 wlf_transform_is_vertical(enum wlf_transform transform)
 {
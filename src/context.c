@@ -3,9 +3,18 @@
 #include <memory.h>
 #include <poll.h>
 #include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <threads.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+#include <linux/sockios.h>
 
 #include <wayland-client-protocol.h>
 #include <viewporter-client-protocol.h>
+#include <presentation-time-client-protocol.h>
 #include <fractional-scale-v1-client-protocol.h>
 #include <input-timestamps-unstable-v1-client-protocol.h>
 #include <relative-pointer-unstable-v1-client-protocol.h>
@@ -17,6 +26,10 @@
 #include <single-pixel-buffer-v1-client-protocol.h>
 #include <content-type-v1-client-protocol.h>
 #include <alpha-modifier-v1-client-protocol.h>
+#include <tearing-control-v1-client-protocol.h>
+#include <fifo-v1-client-protocol.h>
+#include <commit-timing-v1-client-protocol.h>
+#include <linux-dmabuf-unstable-v1-client-protocol.h>
 #include <xdg-shell-client-protocol.h>
 #include <xdg-output-unstable-v1-client-protocol.h>
 #include <xdg-decoration-unstable-v1-client-protocol.h>
@@ -25,9 +38,14 @@
 
 #include <xkbcommon/xkbcommon.h>
 
+#include "common_priv.h"
 #include "context_priv.h"
 #include "input_priv.h"
 #include "output_priv.h"
+#include "shm_priv.h"
+#include "dmabuf_priv.h"
+#include "surface_priv.h"
+#include "trace_priv.h"
 #include "log_priv.h"
 
 constexpr uint32_t WLF_WL_COMPOSITOR_VERSION = 6;
@@ -46,6 +64,11 @@ constexpr uint32_t WLF_WP_IDLE_INHIBIT_MANAGER_V1_VERSION = 1;
 constexpr uint32_t WLF_WP_CONTENT_TYPE_MANAGER_V1_VERSION = 1;
 constexpr uint32_t WLF_WP_SINGLE_PIXEL_BUFFER_MANAGER_V1_VERSION = 1;
 constexpr uint32_t WLF_WP_ALPHA_MODIFIER_V1_VERSION = 1;
+constexpr uint32_t WLF_WP_PRESENTATION_VERSION = 1;
+constexpr uint32_t WLF_WP_TEARING_CONTROL_MANAGER_V1_VERSION = 1;
+constexpr uint32_t WLF_WP_FIFO_MANAGER_V1_VERSION = 1;
+constexpr uint32_t WLF_WP_COMMIT_TIMING_MANAGER_V1_VERSION = 1;
+constexpr uint32_t WLF_WP_LINUX_DMABUF_V1_VERSION = 4;
 constexpr uint32_t WLF_XDG_WM_BASE_VERSION = 6;
 constexpr uint32_t WLF_XDG_WM_DIALOG_V1_VERSION = 1;
 constexpr uint32_t WLF_XDG_OUTPUT_MANAGER_V1_VERSION = 3;
@@ -55,8 +78,8 @@ constexpr uint32_t WLF_EXT_IDLE_NOTIFICATION_V1_VERSION = 1;
 uint64_t
 wlf_new_id()
 {
-    static uint64_t id = 0;
-    return ++id;
+    static atomic_uint_fast64_t id = 0;
+    return atomic_fetch_add_explicit(&id, 1, memory_order_relaxed) + 1;
 }
 
 uint32_t
@@ -95,96 +118,62 @@ wlf_global_destroy(struct wlf_global *global)
     free(global);
 }
 
-static int
-wlf_flush(struct wl_display *display)
+int
+wlf_poll(struct pollfd *fds, nfds_t nfds, int64_t timeout)
 {
-    while (wl_display_flush(display) < 0) {
-        if (errno == EINTR) {
-            continue;
+    int64_t deadline = timeout > 0 ? wlf_get_time_ns() + timeout : 0;
+
+    while (true) {
+        struct timespec ts;
+        struct timespec *tsp = nullptr;
+        if (timeout >= 0) {
+            ts = wlf_ns_to_timespec(timeout);
+            tsp = &ts;
         }
 
-        if (errno != EAGAIN) {
-            return -1;
+        int n = ppoll(fds, nfds, tsp, nullptr);
+        if (n >= 0 || errno != EINTR) {
+            return n;
         }
 
-        struct pollfd fds[1];
-        fds[0].fd = wl_display_get_fd(display);
-        fds[0].events = POLLOUT;
-
-        int n;
-        do {
-            n = poll(fds, 1, -1);
-        } while (n < 0 && errno == EINTR);
-
-        if (n < 0) {
-            return n;
+        if (timeout > 0) {
+            timeout = deadline - wlf_get_time_ns();
+            if (timeout < 0) {
+                timeout = 0;
+            }
         }
     }
-
-    return 0;
 }
 
 static void
-wlf_destroy_globals(struct wlf_context *context)
+wlf_drain_wakeup(void *, int fd, enum wlf_source_events)
 {
-#define WLF_GLOBAL_DESTROY(name, prefix) \
-    if (context->name) { \
-        struct wlf_global *global = prefix##name##_get_user_data(context->name); \
-        wlf_global_destroy(global); \
-        prefix##name##_destroy(context->name); \
-        context->name = nullptr; \
-    }
-
-    WLF_GLOBAL_DESTROY(wl_compositor,)
-    WLF_GLOBAL_DESTROY(wl_subcompositor,)
-    WLF_GLOBAL_DESTROY(wl_data_device_manager,)
-    WLF_GLOBAL_DESTROY(wp_viewporter,)
-    WLF_GLOBAL_DESTROY(wp_fractional_scale_manager_v1,)
-    WLF_GLOBAL_DESTROY(wp_content_type_manager_v1,)
-    WLF_GLOBAL_DESTROY(wp_single_pixel_buffer_manager_v1,)
-    WLF_GLOBAL_DESTROY(wp_alpha_modifier_v1,)
-    WLF_GLOBAL_DESTROY(xdg_wm_base,)
-    WLF_GLOBAL_DESTROY(xdg_wm_dialog_v1,)
-    WLF_GLOBAL_DESTROY(ext_idle_notifier_v1,)
-
-    WLF_GLOBAL_DESTROY(wp_input_timestamps_manager_v1, z)
-    WLF_GLOBAL_DESTROY(wp_relative_pointer_manager_v1, z)
-    WLF_GLOBAL_DESTROY(wp_pointer_constraints_v1, z)
-    WLF_GLOBAL_DESTROY(wp_keyboard_shortcuts_inhibit_manager_v1, z)
-    WLF_GLOBAL_DESTROY(wp_idle_inhibit_manager_v1, z)
-    WLF_GLOBAL_DESTROY(wp_text_input_manager_v3, z)
-    WLF_GLOBAL_DESTROY(xdg_decoration_manager_v1, z)
-    WLF_GLOBAL_DESTROY(xdg_output_manager_v1, z)
-
-    if (context->wl_shm) {
-        struct wlf_global *global = wl_shm_get_user_data(context->wl_shm);
-        wlf_global_destroy(global);
-#ifdef WL_SHM_RELEASE_SINCE_VERSION
-        if (wl_shm_get_version(context->wl_shm) >= WL_SHM_RELEASE_SINCE_VERSION) {
-            wl_shm_release(context->wl_shm);
-        } else
-#endif
-        {
-            wl_shm_destroy(context->wl_shm);
-        }
-        context->wl_shm = nullptr;
-    }
+    uint64_t count;
+    ssize_t n;
+    do {
+        n = read(fd, &count, sizeof(count));
+    } while (n < 0 && errno == EINTR);
+}
 
-    if (context->wp_pointer_gestures_v1) {
-        struct wlf_global *global = zwp_pointer_gestures_v1_get_user_data(
-            context->wp_pointer_gestures_v1);
-        wlf_global_destroy(global);
-        if (zwp_pointer_gestures_v1_get_version(context->wp_pointer_gestures_v1) >=
-            ZWP_POINTER_GESTURES_V1_RELEASE_SINCE_VERSION)
-        {
-            zwp_pointer_gestures_v1_release(context->wp_pointer_gestures_v1);
-        } else {
-            zwp_pointer_gestures_v1_destroy(context->wp_pointer_gestures_v1);
+// Returns 1 if the socket buffer is full and data is still queued.
+// The caller is expected to wait for POLLOUT and try again.
+int
+wlf_context_try_flush(struct wlf_context *context)
+{
+    int n = 0;
+    while (wl_display_flush(context->wl_display) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            return -1;
         }
-        context->wp_pointer_gestures_v1 = nullptr;
+        atomic_fetch_add_explicit(&context->flush_eagain_count, 1, memory_order_relaxed);
+        n = 1;
+        break;
     }
-
-#undef WLF_GLOBAL_DESTROY
+    atomic_store_explicit(&context->flush_pending, n > 0, memory_order_relaxed);
+    return n;
 }
 
 static void *
@@ -209,7 +198,9 @@ wlf_global_bind(
         return nullptr;
     }
 
+    wlf_trace_begin(context, WLF_TIMING_BIND);
     struct wl_proxy *proxy = wl_registry_bind(context->wl_registry, name, wl_interface, version);
+    wlf_trace_end(context, WLF_TIMING_BIND);
     if (!proxy) {
         wlf_error("Failed to bind global %s.\n", wl_interface->name);
         wlf_global_destroy(global);
@@ -254,6 +245,12 @@ wl_shm_format(void *data, struct wl_shm *, uint32_t format)
     }
 
     *next = format;
+
+    int32_t index = wlf_shm_format_index(format);
+    if (index >= 0) {
+        context->shm_format_mask |= UINT64_C(1) << index;
+    }
+
     wlf_debug("Added wl_shm format 0x%08w32x.\n", format);
 }
 
@@ -263,6 +260,256 @@ static const struct wl_shm_listener wl_shm_listener = {
 
 // endregion
 
+// region WP Presentation
+
+static void
+wp_presentation_clock_id(void *data, struct wp_presentation *, uint32_t clk_id)
+{
+    struct wlf_global *global = data;
+    global->context->presentation_clock = (clockid_t)clk_id;
+    wlf_debug("Presentation clock is %w32u.\n", clk_id);
+}
+
+static const struct wp_presentation_listener wp_presentation_listener = {
+    .clock_id = wp_presentation_clock_id,
+};
+
+// endregion
+
+// region Global Table
+
+#define WLF_GLOBAL_DESTROY_FUNC(ident, prefix) \
+    static void \
+    wlf_##ident##_destroy(void *proxy) \
+    { \
+        prefix##ident##_destroy(proxy); \
+    }
+
+WLF_GLOBAL_DESTROY_FUNC(wl_compositor,)
+WLF_GLOBAL_DESTROY_FUNC(wl_subcompositor,)
+WLF_GLOBAL_DESTROY_FUNC(wl_data_device_manager,)
+WLF_GLOBAL_DESTROY_FUNC(wp_viewporter,)
+WLF_GLOBAL_DESTROY_FUNC(wp_fractional_scale_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_content_type_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_single_pixel_buffer_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_alpha_modifier_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_presentation,)
+WLF_GLOBAL_DESTROY_FUNC(wp_tearing_control_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_fifo_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_commit_timing_manager_v1,)
+WLF_GLOBAL_DESTROY_FUNC(xdg_wm_base,)
+WLF_GLOBAL_DESTROY_FUNC(xdg_wm_dialog_v1,)
+WLF_GLOBAL_DESTROY_FUNC(ext_idle_notifier_v1,)
+WLF_GLOBAL_DESTROY_FUNC(wp_input_timestamps_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_relative_pointer_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_pointer_constraints_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_keyboard_shortcuts_inhibit_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_idle_inhibit_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_text_input_manager_v3, z)
+WLF_GLOBAL_DESTROY_FUNC(xdg_decoration_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(xdg_output_manager_v1, z)
+WLF_GLOBAL_DESTROY_FUNC(wp_linux_dmabuf_v1, z)
+
+#undef WLF_GLOBAL_DESTROY_FUNC
+
+static void
+wlf_wl_shm_destroy(void *proxy)
+{
+#ifdef WL_SHM_RELEASE_SINCE_VERSION
+    if (wl_shm_get_version(proxy) >= WL_SHM_RELEASE_SINCE_VERSION) {
+        wl_shm_release(proxy);
+        return;
+    }
+#endif
+    wl_shm_destroy(proxy);
+}
+
+static void
+wlf_wp_pointer_gestures_v1_destroy(void *proxy)
+{
+    if (zwp_pointer_gestures_v1_get_version(proxy) >=
+        ZWP_POINTER_GESTURES_V1_RELEASE_SINCE_VERSION)
+    {
+        zwp_pointer_gestures_v1_release(proxy);
+    } else {
+        zwp_pointer_gestures_v1_destroy(proxy);
+    }
+}
+
+struct wlf_global_desc {
+    const struct wl_interface *interface;
+    size_t offset;
+    const void *listener;
+    uint32_t max_version;
+    enum wlf_feature feature;
+    bool required;
+    // Destroying the proxy while objects created from it exist is an error.
+    bool keep_bound;
+    void (*destroy)(void *proxy);
+    void (*bound)(struct wlf_context *context);
+};
+
+#define WLF_GLOBAL_DESC(ident, prefix, version, ...) \
+    { \
+        .interface = &prefix##ident##_interface, \
+        .offset = offsetof(struct wlf_context, ident), \
+        .max_version = version, \
+        .destroy = wlf_##ident##_destroy, \
+        __VA_ARGS__ \
+    }
+
+static const struct wlf_global_desc wlf_global_descs[] = {
+    WLF_GLOBAL_DESC(wl_compositor,, WLF_WL_COMPOSITOR_VERSION,
+        .required = true),
+    WLF_GLOBAL_DESC(wl_subcompositor,, WLF_WL_SUBCOMPOSITOR_VERSION,
+        .required = true),
+    WLF_GLOBAL_DESC(wl_shm,, WLF_WL_SHM_VERSION,
+        .required = true,
+        .listener = &wl_shm_listener),
+    WLF_GLOBAL_DESC(wl_data_device_manager,, WLF_WL_DATA_DEVICE_MANAGER_VERSION,
+        .feature = WLF_FEATURE_DATA_DEVICE),
+    WLF_GLOBAL_DESC(wp_viewporter,, WLF_WP_VIEWPORTER_VERSION,
+        .feature = WLF_FEATURE_VIEWPORTER),
+    WLF_GLOBAL_DESC(wp_fractional_scale_manager_v1,, WLF_WP_FRACTIONAL_SCALE_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_FRACTIONAL_SCALE),
+    WLF_GLOBAL_DESC(wp_input_timestamps_manager_v1, z, WLF_WP_INPUT_TIMESTAMPS_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_INPUT_TIMESTAMPS),
+    WLF_GLOBAL_DESC(wp_text_input_manager_v3, z, WLF_WP_TEXT_INPUT_MANAGER_V3_VERSION,
+        .feature = WLF_FEATURE_TEXT_INPUT),
+    WLF_GLOBAL_DESC(wp_relative_pointer_manager_v1, z, WLF_WP_RELATIVE_POINTER_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_RELATIVE_POINTER),
+    WLF_GLOBAL_DESC(wp_pointer_constraints_v1, z, WLF_WP_POINTER_CONSTRAINTS_V1_VERSION,
+        .feature = WLF_FEATURE_POINTER_CONSTRAINTS),
+    WLF_GLOBAL_DESC(wp_pointer_gestures_v1, z, WLF_WP_POINTER_GESTURES_V1_VERSION,
+        .feature = WLF_FEATURE_POINTER_GESTURES),
+    WLF_GLOBAL_DESC(wp_keyboard_shortcuts_inhibit_manager_v1, z, WLF_WP_KEYBOARD_SHORTCUTS_INHIBIT_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_KEYBOARD_SHORTCUTS_INHIBIT),
+    WLF_GLOBAL_DESC(wp_idle_inhibit_manager_v1, z, WLF_WP_IDLE_INHIBIT_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_IDLE_INHIBIT),
+    WLF_GLOBAL_DESC(wp_content_type_manager_v1,, WLF_WP_CONTENT_TYPE_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_CONTENT_TYPE),
+    WLF_GLOBAL_DESC(wp_single_pixel_buffer_manager_v1,, WLF_WP_SINGLE_PIXEL_BUFFER_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_SINGLE_PIXEL_BUFFER),
+    WLF_GLOBAL_DESC(wp_alpha_modifier_v1,, WLF_WP_ALPHA_MODIFIER_V1_VERSION,
+        .feature = WLF_FEATURE_ALPHA_MODIFIER),
+    WLF_GLOBAL_DESC(wp_presentation,, WLF_WP_PRESENTATION_VERSION,
+        .feature = WLF_FEATURE_PRESENTATION,
+        .listener = &wp_presentation_listener),
+    WLF_GLOBAL_DESC(wp_tearing_control_manager_v1,, WLF_WP_TEARING_CONTROL_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_TEARING_CONTROL),
+    WLF_GLOBAL_DESC(wp_fifo_manager_v1,, WLF_WP_FIFO_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_FIFO),
+    WLF_GLOBAL_DESC(wp_commit_timing_manager_v1,, WLF_WP_COMMIT_TIMING_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_COMMIT_TIMING),
+    WLF_GLOBAL_DESC(wp_linux_dmabuf_v1, z, WLF_WP_LINUX_DMABUF_V1_VERSION,
+        .feature = WLF_FEATURE_LINUX_DMABUF),
+    WLF_GLOBAL_DESC(xdg_wm_base,, WLF_XDG_WM_BASE_VERSION,
+        .listener = &xdg_wm_base_listener,
+        .keep_bound = true),
+    WLF_GLOBAL_DESC(xdg_wm_dialog_v1,, WLF_XDG_WM_DIALOG_V1_VERSION,
+        .feature = WLF_FEATURE_DIALOG),
+    WLF_GLOBAL_DESC(xdg_decoration_manager_v1, z, WLF_XDG_DECORATION_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_DECORATION),
+    WLF_GLOBAL_DESC(xdg_output_manager_v1, z, WLF_XDG_OUTPUT_MANAGER_V1_VERSION,
+        .feature = WLF_FEATURE_XDG_OUTPUT,
+        .bound = wlf_output_init_xdg_all),
+    WLF_GLOBAL_DESC(ext_idle_notifier_v1,, WLF_EXT_IDLE_NOTIFICATION_V1_VERSION,
+        .feature = WLF_FEATURE_IDLE_NOTIFY),
+};
+
+#undef WLF_GLOBAL_DESC
+
+constexpr size_t WLF_GLOBAL_DESC_COUNT = sizeof(wlf_global_descs) / sizeof(wlf_global_descs[0]);
+constexpr size_t WLF_GLOBAL_INDEX_SIZE = 64;
+
+static_assert(WLF_GLOBAL_DESC_COUNT * 2 <= WLF_GLOBAL_INDEX_SIZE);
+
+// Open addressing index into wlf_global_descs, 0 marks an empty bucket.
+static uint8_t wlf_global_index[WLF_GLOBAL_INDEX_SIZE];
+static once_flag wlf_global_index_once = ONCE_FLAG_INIT;
+
+static uint32_t
+wlf_global_hash(const char *str)
+{
+    uint32_t hash = 2166136261u;
+    for (; *str; ++str) {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void
+wlf_global_index_init(void)
+{
+    for (size_t i = 0; i < WLF_GLOBAL_DESC_COUNT; ++i) {
+        uint32_t bucket = wlf_global_hash(wlf_global_descs[i].interface->name);
+        while (wlf_global_index[bucket % WLF_GLOBAL_INDEX_SIZE] != 0) {
+            ++bucket;
+        }
+        wlf_global_index[bucket % WLF_GLOBAL_INDEX_SIZE] = (uint8_t)(i + 1);
+    }
+}
+
+static const struct wlf_global_desc *
+wlf_global_desc_find(const char *interface)
+{
+    call_once(&wlf_global_index_once, wlf_global_index_init);
+
+    uint32_t bucket = wlf_global_hash(interface);
+    uint8_t index;
+    while ((index = wlf_global_index[bucket % WLF_GLOBAL_INDEX_SIZE]) != 0) {
+        const struct wlf_global_desc *desc = &wlf_global_descs[index - 1];
+        if (strcmp(desc->interface->name, interface) == 0) {
+            return desc;
+        }
+        ++bucket;
+    }
+    return nullptr;
+}
+
+static inline void **
+wlf_global_slot(struct wlf_context *context, const struct wlf_global_desc *desc)
+{
+    return (void **)((char *)context + desc->offset);
+}
+
+static void
+wlf_global_unbind(struct wlf_context *context, const struct wlf_global_desc *desc)
+{
+    void **slot = wlf_global_slot(context, desc);
+    struct wlf_global *global = wl_proxy_get_user_data(*slot);
+    desc->destroy(*slot);
+    *slot = nullptr;
+    wlf_global_destroy(global);
+}
+
+static void
+wlf_destroy_globals(struct wlf_context *context)
+{
+    for (size_t i = 0; i < WLF_GLOBAL_DESC_COUNT; ++i) {
+        if (*wlf_global_slot(context, &wlf_global_descs[i])) {
+            wlf_global_unbind(context, &wlf_global_descs[i]);
+        }
+    }
+}
+
+static bool
+wlf_has_required_globals(struct wlf_context *context)
+{
+    bool ok = true;
+    for (size_t i = 0; i < WLF_GLOBAL_DESC_COUNT; ++i) {
+        const struct wlf_global_desc *desc = &wlf_global_descs[i];
+        if (desc->required && !*wlf_global_slot(context, desc)) {
+            wlf_error("Required global %s not available.\n", desc->interface->name);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// endregion
+
 // region WL Registry
 
 static void
@@ -275,35 +522,29 @@ wl_registry_global(
 {
     struct wlf_context *context = data;
 
-#define WLF_MATCH(ident, prefix) \
-    ((strcmp(interface, prefix##ident##_interface.name) == 0) && !context->ident)
+    const struct wlf_global_desc *desc = wlf_global_desc_find(interface);
+    if (desc) {
+        if (desc->feature && !(context->features & desc->feature)) {
+            wlf_debug("Skipping %s, feature not selected.\n", interface);
+            return;
+        }
 
-    if WLF_MATCH(wl_compositor,) {
-        context->wl_compositor = wlf_global_bind(
-            context,
-            name,
-            &wl_compositor_interface,
-            nullptr,
-            version,
-            WLF_WL_COMPOSITOR_VERSION);
-    }
-    else if WLF_MATCH(wl_subcompositor,) {
-        context->wl_subcompositor = wlf_global_bind(
-            context,
-            name,
-            &wl_subcompositor_interface,
-            nullptr,
-            version,
-            WLF_WL_SUBCOMPOSITOR_VERSION);
-    }
-    else if WLF_MATCH(wl_shm,) {
-        context->wl_shm = wlf_global_bind(
+        void **slot = wlf_global_slot(context, desc);
+        if (*slot) {
+            return;
+        }
+
+        *slot = wlf_global_bind(
             context,
             name,
-            &wl_shm_interface,
-            &wl_shm_listener,
+            desc->interface,
+            desc->listener,
             version,
-            WLF_WL_SHM_VERSION);
+            desc->max_version);
+
+        if (*slot && desc->bound) {
+            desc->bound(context);
+        }
     }
     else if (strcmp(interface, wl_seat_interface.name) == 0) {
         struct wlf_seat *seat = wlf_seat_add(context, name, version);
@@ -312,173 +553,6 @@ wl_registry_global(
     else if (strcmp(interface, wl_output_interface.name) == 0) {
         wlf_output_bind(context, name, version);
     }
-    else if WLF_MATCH(wl_data_device_manager,) {
-        context->wl_data_device_manager = wlf_global_bind(
-            context,
-            name,
-            &wl_data_device_manager_interface,
-            nullptr,
-            version,
-            WLF_WL_DATA_DEVICE_MANAGER_VERSION);
-    }
-    else if WLF_MATCH(wp_viewporter,) {
-        context->wp_viewporter = wlf_global_bind(
-            context,
-            name,
-            &wp_viewporter_interface,
-            nullptr,
-            version,
-            WLF_WP_VIEWPORTER_VERSION);
-    }
-    else if WLF_MATCH(wp_fractional_scale_manager_v1,) {
-        context->wp_fractional_scale_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &wp_fractional_scale_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_FRACTIONAL_SCALE_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_input_timestamps_manager_v1, z) {
-        context->wp_input_timestamps_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_input_timestamps_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_INPUT_TIMESTAMPS_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_text_input_manager_v3, z) {
-        context->wp_text_input_manager_v3 = wlf_global_bind(
-            context,
-            name,
-            &zwp_text_input_manager_v3_interface,
-            nullptr,
-            version,
-            WLF_WP_TEXT_INPUT_MANAGER_V3_VERSION);
-    }
-    else if WLF_MATCH(wp_relative_pointer_manager_v1, z) {
-        context->wp_relative_pointer_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_relative_pointer_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_RELATIVE_POINTER_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_pointer_constraints_v1, z) {
-        context->wp_pointer_constraints_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_pointer_constraints_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_POINTER_CONSTRAINTS_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_pointer_gestures_v1, z) {
-        context->wp_pointer_gestures_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_pointer_gestures_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_POINTER_GESTURES_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_keyboard_shortcuts_inhibit_manager_v1, z) {
-        context->wp_keyboard_shortcuts_inhibit_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_keyboard_shortcuts_inhibit_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_KEYBOARD_SHORTCUTS_INHIBIT_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_idle_inhibit_manager_v1, z) {
-        context->wp_idle_inhibit_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zwp_idle_inhibit_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_IDLE_INHIBIT_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_content_type_manager_v1,) {
-        context->wp_content_type_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &wp_content_type_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_CONTENT_TYPE_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_single_pixel_buffer_manager_v1,) {
-        context->wp_single_pixel_buffer_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &wp_single_pixel_buffer_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_SINGLE_PIXEL_BUFFER_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(wp_alpha_modifier_v1,) {
-        context->wp_alpha_modifier_v1 = wlf_global_bind(
-            context,
-            name,
-            &wp_alpha_modifier_v1_interface,
-            nullptr,
-            version,
-            WLF_WP_ALPHA_MODIFIER_V1_VERSION);
-    }
-    else if WLF_MATCH(xdg_wm_base,) {
-        context->xdg_wm_base = wlf_global_bind(
-            context,
-            name,
-            &xdg_wm_base_interface,
-            &xdg_wm_base_listener,
-            version,
-            WLF_XDG_WM_BASE_VERSION);
-    }
-    else if WLF_MATCH(xdg_wm_dialog_v1,) {
-        context->xdg_wm_dialog_v1 = wlf_global_bind(
-            context,
-            name,
-            &xdg_wm_dialog_v1_interface,
-            nullptr,
-            version,
-            WLF_XDG_WM_DIALOG_V1_VERSION);
-    }
-    else if WLF_MATCH(xdg_decoration_manager_v1, z) {
-        context->xdg_decoration_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zxdg_decoration_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_XDG_DECORATION_MANAGER_V1_VERSION);
-    }
-    else if WLF_MATCH(xdg_output_manager_v1, z) {
-        context->xdg_output_manager_v1 = wlf_global_bind(
-            context,
-            name,
-            &zxdg_output_manager_v1_interface,
-            nullptr,
-            version,
-            WLF_XDG_OUTPUT_MANAGER_V1_VERSION);
-        if (context->xdg_output_manager_v1) {
-            wlf_output_init_xdg_all(context);
-        }
-    }
-    else if WLF_MATCH(ext_idle_notifier_v1,) {
-        context->ext_idle_notifier_v1 = wlf_global_bind(
-            context,
-            name,
-            &ext_idle_notifier_v1_interface,
-            nullptr,
-            version,
-            WLF_EXT_IDLE_NOTIFICATION_V1_VERSION);
-    }
-
-#undef WLF_MATCH
 }
 
 static void
@@ -506,57 +580,30 @@ wl_registry_global_remove(
         }
     }
 
-#define WLF_GLOBAL_REMOVE(ident, prefix) \
-    if (context->ident) { \
-        struct wlf_global *global = prefix##ident##_get_user_data(context->ident); \
-        if (global->name == name) { \
-            prefix##ident##_destroy(context->ident); \
-            context->ident = nullptr;  \
-            wlf_global_destroy(global); \
-            return; \
-        } \
-    }
-
-    WLF_GLOBAL_REMOVE(wl_data_device_manager,);
-    WLF_GLOBAL_REMOVE(wp_viewporter,)
-    WLF_GLOBAL_REMOVE(wp_fractional_scale_manager_v1,)
-    WLF_GLOBAL_REMOVE(wp_content_type_manager_v1,)
-    WLF_GLOBAL_REMOVE(wp_single_pixel_buffer_manager_v1,)
-    WLF_GLOBAL_REMOVE(wp_alpha_modifier_v1,)
-    WLF_GLOBAL_REMOVE(ext_idle_notifier_v1,)
-    WLF_GLOBAL_REMOVE(xdg_wm_dialog_v1,)
-
-    WLF_GLOBAL_REMOVE(wp_input_timestamps_manager_v1, z)
-    WLF_GLOBAL_REMOVE(wp_relative_pointer_manager_v1, z)
-    WLF_GLOBAL_REMOVE(wp_pointer_constraints_v1, z)
-    WLF_GLOBAL_REMOVE(wp_keyboard_shortcuts_inhibit_manager_v1, z)
-    WLF_GLOBAL_REMOVE(wp_idle_inhibit_manager_v1, z)
-    WLF_GLOBAL_REMOVE(wp_text_input_manager_v3, z)
-    WLF_GLOBAL_REMOVE(xdg_decoration_manager_v1, z)
-    WLF_GLOBAL_REMOVE(xdg_output_manager_v1, z)
-
-#undef WLF_GLOBAL_REMOVE
-
-    if (context->wp_pointer_gestures_v1) {
-        struct wlf_global *global = zwp_pointer_gestures_v1_get_user_data(
-            context->wp_pointer_gestures_v1);
-        if (global->name == name) {
-            if (zwp_pointer_gestures_v1_get_version(context->wp_pointer_gestures_v1) >=
-                ZWP_POINTER_GESTURES_V1_RELEASE_SINCE_VERSION)
-            {
-                zwp_pointer_gestures_v1_release(context->wp_pointer_gestures_v1);
-            } else {
-                zwp_pointer_gestures_v1_destroy(context->wp_pointer_gestures_v1);
-            }
-            context->wp_pointer_gestures_v1 = nullptr;
-            wlf_global_destroy(global);
+    for (size_t i = 0; i < WLF_GLOBAL_DESC_COUNT; ++i) {
+        const struct wlf_global_desc *desc = &wlf_global_descs[i];
+        void *proxy = *wlf_global_slot(context, desc);
+        if (!proxy) {
+            continue;
+        }
+
+        struct wlf_global *global = wl_proxy_get_user_data(proxy);
+        if (global->name != name) {
+            continue;
+        }
+
+        // Objects created from these globals stay valid, so they are kept
+        // bound and the context refuses any further work instead.
+        if (desc->required || desc->keep_bound) {
+            wlf_error("Compositor removed global %s.\n", desc->interface->name);
+            context->lost = true;
             return;
         }
+        wlf_global_unbind(context, desc);
+        return;
     }
 
-    // TODO: Remove temporary abort and implement proper context invalidation
-    wlf_error("Compositor removed critical global %w32u.\n", name);
-    abort();
+    wlf_debug("Ignoring removal of unbound global %w32u.\n", name);
 }
 
 static const struct wl_registry_listener wl_registry_listener = {
@@ -566,6 +613,51 @@ static const struct wl_registry_listener wl_registry_listener = {
 
 // endregion
 
+// Completes initialization once the initial set of globals is known.
+static enum wlf_result
+wlf_context_setup(struct wlf_context *context)
+{
+    if (!wlf_has_required_globals(context)) {
+        return WLF_ERROR_WAYLAND;
+    }
+
+    context->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (!context->xkb_context) {
+        wlf_error("Failed to create xkb context.\n");
+        return WLF_ERROR_UNKNOWN;
+    }
+
+    context->ready = true;
+    return WLF_SUCCESS;
+}
+
+// region WL Callback
+
+static void
+wl_sync_done(void *data, struct wl_callback *wl_callback, uint32_t)
+{
+    struct wlf_context *context = data;
+
+    wl_callback_destroy(wl_callback);
+    context->wl_sync_callback = nullptr;
+    wlf_trace_end(context, WLF_TIMING_REGISTRY);
+
+    enum wlf_result result = wlf_context_setup(context);
+    if (result < WLF_SUCCESS) {
+        wlf_error("Failed to initialize context.\n");
+    }
+
+    if (context->listener.ready) {
+        context->listener.ready(context->user_data, result);
+    }
+}
+
+static const struct wl_callback_listener wl_sync_listener = {
+    .done = wl_sync_done,
+};
+
+// endregion
+
 static enum wlf_result
 wlf_context_init(
     struct wlf_context *context,
@@ -574,11 +666,44 @@ wlf_context_init(
 {
     wlf_debug("Initializing context.\n");
 
+#ifdef WLF_TRACE
+    wlf_trace_init(&context->trace, info->flags & WLF_CONTEXT_FLAGS_LOG_TIMING);
+#endif
+
     enum wlf_result result;
     context->listener = *listener;
     context->user_data = info->user_data;
+    context->presentation_clock = CLOCK_MONOTONIC;
+    context->features = (info->flags & WLF_CONTEXT_FLAGS_SELECT_FEATURES)
+                      ? info->features
+                      : ~WLF_FEATURE_NONE;
 
+    result = wlf_loop_init(&context->loop);
+    if (result < WLF_SUCCESS) {
+        goto err_loop;
+    }
+
+    context->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (context->wakeup_fd < 0) {
+        wlf_error("Failed to create wakeup eventfd.\n");
+        result = WLF_ERROR_UNKNOWN;
+        goto err_wakeup;
+    }
+
+    context->wakeup_source = wlf_loop_add_fd(
+        &context->loop,
+        context->wakeup_fd,
+        WLF_SOURCE_EVENTS_READABLE,
+        wlf_drain_wakeup,
+        context);
+    if (!context->wakeup_source) {
+        result = WLF_ERROR_UNKNOWN;
+        goto err_wakeup_source;
+    }
+
+    wlf_trace_begin(context, WLF_TIMING_CONNECT);
     context->wl_display = wl_display_connect(info->display);
+    wlf_trace_end(context, WLF_TIMING_CONNECT);
     if (!context->wl_display) {
         wlf_error("Failed to connect to wayland socket.\n");
         result = WLF_ERROR_WAYLAND;
@@ -588,15 +713,15 @@ wlf_context_init(
     wl_list_init(&context->seat_list);
     wl_list_init(&context->output_list);
     wl_list_init(&context->surface_list);
+    wl_list_init(&context->configure_list);
     wl_array_init(&context->format_array);
 
-    context->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-    if (!context->xkb_context) {
-        wlf_error("Failed to create xkb context.\n");
+    if (mtx_init(&context->output_lock, mtx_plain) != thrd_success) {
         result = WLF_ERROR_UNKNOWN;
-        goto err_xkb;
+        goto err_lock;
     }
 
+    wlf_trace_begin(context, WLF_TIMING_REGISTRY);
     context->wl_registry = wl_display_get_registry(context->wl_display);
     if (!context->wl_registry) {
         wlf_error("Failed to get registry.\n");
@@ -605,31 +730,56 @@ wlf_context_init(
     }
 
     wl_registry_add_listener(context->wl_registry, &wl_registry_listener, context);
+
+    // In async mode the initial globals are collected by the regular event
+    // dispatch and the listener is notified once they are complete.
+    if (info->flags & WLF_CONTEXT_FLAGS_ASYNC) {
+        context->wl_sync_callback = wl_display_sync(context->wl_display);
+        if (!context->wl_sync_callback) {
+            result = WLF_ERROR_OUT_OF_MEMORY;
+            goto err_globals;
+        }
+        wl_callback_add_listener(context->wl_sync_callback, &wl_sync_listener, context);
+
+        if (wlf_context_try_flush(context) < 0) {
+            result = WLF_ERROR_WAYLAND;
+            goto err_globals;
+        }
+        return WLF_PENDING;
+    }
+
     wl_display_roundtrip(context->wl_display);
+    wlf_trace_end(context, WLF_TIMING_REGISTRY);
 
-    if (!context->wl_compositor ||
-        !context->wl_subcompositor ||
-        !context->wl_shm)
-    {
-        wlf_error("Required globals not available.\n");
-        result = WLF_ERROR_WAYLAND;
+    result = wlf_context_setup(context);
+    if (result < WLF_SUCCESS) {
         goto err_globals;
     }
 
     return WLF_SUCCESS;
 
 err_globals:
+    if (context->wl_sync_callback) {
+        wl_callback_destroy(context->wl_sync_callback);
+    }
     wlf_destroy_seats(context);
     wlf_destroy_outputs(context);
     wlf_destroy_globals(context);
     wl_registry_destroy(context->wl_registry);
     wl_display_roundtrip(context->wl_display);
-err_registry:
     xkb_context_unref(context->xkb_context);
-err_xkb:
+err_registry:
+    mtx_destroy(&context->output_lock);
+err_lock:
     wl_array_release(&context->format_array);
     wl_display_disconnect(context->wl_display);
 err_display:
+    wlf_source_remove(context->wakeup_source);
+err_wakeup_source:
+    close(context->wakeup_fd);
+err_wakeup:
+    wlf_loop_fini(&context->loop);
+err_loop:
     return result;
 }
 
@@ -637,14 +787,26 @@ static void
 wlf_context_fini(struct wlf_context *context)
 {
     wlf_debug("Uninitializing context.\n");
+    if (context->wl_sync_callback) {
+        wl_callback_destroy(context->wl_sync_callback);
+    }
+    if (context->dmabuf_feedback) {
+        wlf_dmabuf_state_destroy(context->dmabuf_feedback);
+    }
     wlf_destroy_seats(context);
     wlf_destroy_outputs(context);
     wlf_destroy_globals(context);
     wl_registry_destroy(context->wl_registry);
     wl_display_roundtrip(context->wl_display);
     xkb_context_unref(context->xkb_context);
+    mtx_destroy(&context->output_lock);
     wl_array_release(&context->format_array);
+#ifdef WLF_TRACE
+    wlf_trace_fini(&context->trace);
+#endif
     wl_display_disconnect(context->wl_display);
+    wlf_loop_fini(&context->loop);
+    close(context->wakeup_fd);
 }
 
 // region Public API
@@ -674,6 +836,12 @@ wlf_context_create(
     return result;
 }
 
+bool
+wlf_context_is_ready(struct wlf_context *context)
+{
+    return context->ready;
+}
+
 void
 wlf_context_destroy(struct wlf_context *context)
 {
@@ -682,36 +850,86 @@ wlf_context_destroy(struct wlf_context *context)
     free(context);
 }
 
+enum wlf_feature
+wlf_context_get_features(struct wlf_context *context)
+{
+    enum wlf_feature features = WLF_FEATURE_NONE;
+    for (size_t i = 0; i < WLF_GLOBAL_DESC_COUNT; ++i) {
+        const struct wlf_global_desc *desc = &wlf_global_descs[i];
+        if (*wlf_global_slot(context, desc)) {
+            features |= desc->feature;
+        }
+    }
+    return features;
+}
+
+int64_t
+wlf_context_get_presentation_time(struct wlf_context *context)
+{
+    return wlf_get_clock_ns(context->presentation_clock);
+}
+
+// Surfaces with their own queue are flushed by wlf_surface_dispatch(). The
+// configure callbacks may destroy any surface, which unlinks it, so each one
+// is popped off the list before it is flushed.
+static void
+wlf_context_flush_configures(struct wlf_context *context)
+{
+    while (!wl_list_empty(&context->configure_list)) {
+        struct wlf_surface *surface =
+            wl_container_of(context->configure_list.next, surface, configure_link);
+        wl_list_remove(&surface->configure_link);
+        wl_list_init(&surface->configure_link);
+        wlf_surface_flush_configure(surface);
+    }
+}
+
 enum wlf_result
 wlf_dispatch_events(struct wlf_context *context, int64_t timeout)
 {
     struct wl_display *wl_display = context->wl_display;
 
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+
     if (wl_display_prepare_read(wl_display) < 0) {
         int n = wl_display_dispatch_pending(wl_display);
-        return n < 0 ? WLF_ERROR_WAYLAND : WLF_SUCCESS;
+        if (n < 0) {
+            return WLF_ERROR_WAYLAND;
+        }
+        wlf_context_flush_configures(context);
+        return context->lost ? WLF_ERROR_LOST : WLF_SUCCESS;
     }
 
-    int n = wlf_flush(wl_display);
+    // A full socket buffer must not block event processing, so wait for
+    // POLLOUT together with everything else and resume the flush later.
+    int n = wlf_context_try_flush(context);
     if (n < 0) {
         wl_display_cancel_read(wl_display);
         return WLF_ERROR_WAYLAND;
     }
 
-    struct pollfd fds[1];
+    // The epoll fd becomes readable when any fd, timer or the
+    // wakeup eventfd registered with the loop is ready.
+    struct pollfd fds[2];
     fds[0].fd = wl_display_get_fd(wl_display);
-    fds[0].events = POLLIN;
-
-    do {
-        n = poll(fds, 1, 0);
-    } while (n < 0 && errno == EINTR);
+    fds[0].events = n > 0 ? POLLIN | POLLOUT : POLLIN;
+    fds[1].fd = context->loop.epoll_fd;
+    fds[1].events = POLLIN;
 
+    n = wlf_poll(fds, 2, timeout);
     if (n < 0) {
         wl_display_cancel_read(wl_display);
         return WLF_ERROR_WAYLAND;
     }
 
-    if (fds[0].revents & POLLIN) {
+    if ((fds[0].revents & POLLOUT) && wlf_context_try_flush(context) < 0) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_WAYLAND;
+    }
+
+    if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
         n = wl_display_read_events(wl_display);
         if (n < 0) {
             return WLF_ERROR_WAYLAND;
@@ -724,7 +942,122 @@ wlf_dispatch_events(struct wlf_context *context, int64_t timeout)
     if (n < 0) {
         return WLF_ERROR_WAYLAND;
     }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+    wlf_context_flush_configures(context);
+
+    if (fds[1].revents & POLLIN) {
+        n = wlf_loop_dispatch(&context->loop);
+        if (n < 0) {
+            return WLF_ERROR_UNKNOWN;
+        }
+    }
+
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_context_wakeup(struct wlf_context *context)
+{
+    uint64_t one = 1;
+    ssize_t n;
+    do {
+        n = write(context->wakeup_fd, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+
+    // EAGAIN means the counter is saturated, so a wakeup is already pending.
+    if (n < 0 && errno != EAGAIN) {
+        return WLF_ERROR_UNKNOWN;
+    }
+    return WLF_SUCCESS;
+}
+
+int
+wlf_context_get_fd(struct wlf_context *context)
+{
+    return wl_display_get_fd(context->wl_display);
+}
+
+enum wlf_result
+wlf_context_prepare(struct wlf_context *context)
+{
+    struct wl_display *wl_display = context->wl_display;
+
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+
+    while (wl_display_prepare_read(wl_display) < 0) {
+        if (wl_display_dispatch_pending(wl_display) < 0) {
+            return WLF_ERROR_WAYLAND;
+        }
+    }
+    if (context->lost) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_LOST;
+    }
+    wlf_context_flush_configures(context);
+
+    int n = wlf_context_try_flush(context);
+    if (n < 0) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_WAYLAND;
+    }
+
+    return n > 0 ? WLF_PENDING : WLF_SUCCESS;
+}
 
+enum wlf_result
+wlf_context_flush(struct wlf_context *context)
+{
+    int n = wlf_context_try_flush(context);
+    if (n < 0) {
+        return WLF_ERROR_WAYLAND;
+    }
+    return n > 0 ? WLF_PENDING : WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_context_get_flush_stats(struct wlf_context *context, struct wlf_flush_stats *stats)
+{
+    stats->eagain_count = atomic_load_explicit(&context->flush_eagain_count, memory_order_relaxed);
+    stats->pending = atomic_load_explicit(&context->flush_pending, memory_order_relaxed);
+    stats->queued_bytes = 0;
+
+    int queued = 0;
+    if (ioctl(wl_display_get_fd(context->wl_display), SIOCOUTQ, &queued) < 0) {
+        return WLF_ERROR_UNKNOWN;
+    }
+    stats->queued_bytes = (uint32_t)queued;
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_context_read(struct wlf_context *context)
+{
+    if (wl_display_read_events(context->wl_display) < 0) {
+        return WLF_ERROR_WAYLAND;
+    }
+    return WLF_SUCCESS;
+}
+
+void
+wlf_context_cancel_read(struct wlf_context *context)
+{
+    wl_display_cancel_read(context->wl_display);
+}
+
+enum wlf_result
+wlf_context_dispatch_pending(struct wlf_context *context)
+{
+    if (wl_display_dispatch_pending(context->wl_display) < 0) {
+        return WLF_ERROR_WAYLAND;
+    }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+    wlf_context_flush_configures(context);
     return WLF_SUCCESS;
 }
 
@@ -1,6 +1,16 @@
 #pragma once
 
+#include <poll.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
 #include "wlf/context.h"
+#include "loop_priv.h"
+#include "trace_priv.h"
+
+constexpr uint32_t WLF_OUTPUT_SLOT_COUNT = 64;
+constexpr uint32_t WLF_OUTPUT_SLOT_NONE = UINT32_MAX;
 
 struct wlf_global {
     struct wlf_context *context;
@@ -11,14 +21,38 @@ struct wlf_global {
 
 struct wlf_context {
     struct wlf_context_listener listener;
+    enum wlf_feature features;
 
     struct wl_display *wl_display;
     struct wl_registry *wl_registry;
+    struct wl_callback *wl_sync_callback;
+    bool ready;
+    // Set once the compositor removes a required global.
+    bool lost;
+
+#ifdef WLF_TRACE
+    struct wlf_trace trace;
+#endif
+
+    struct wlf_loop loop;
+    struct wlf_source *wakeup_source;
+    int wakeup_fd;
+
+    atomic_uint_fast64_t flush_eagain_count;
+    atomic_bool flush_pending;
 
     struct wl_list seat_list;
     struct wl_list output_list;
     struct wl_list surface_list;
+    // Surfaces on the default queue with a configure to flush.
+    struct wl_list configure_list;
+    // Surfaces with their own queue enter and leave outputs on their thread
+    // while outputs come and go on the main one.
+    mtx_t output_lock;
+    struct wlf_output *output_slots[WLF_OUTPUT_SLOT_COUNT];
+    uint64_t output_slot_mask;
     struct wl_array format_array;
+    uint64_t shm_format_mask;
 
     struct wl_compositor                             *wl_compositor;
     struct wl_subcompositor                          *wl_subcompositor;
@@ -36,6 +70,11 @@ struct wlf_context {
     struct zwp_idle_inhibit_manager_v1               *wp_idle_inhibit_manager_v1;
     struct wp_content_type_manager_v1                *wp_content_type_manager_v1;
     struct wp_alpha_modifier_v1                      *wp_alpha_modifier_v1;
+    struct wp_presentation                           *wp_presentation;
+    struct wp_tearing_control_manager_v1             *wp_tearing_control_manager_v1;
+    struct wp_fifo_manager_v1                        *wp_fifo_manager_v1;
+    struct wp_commit_timing_manager_v1               *wp_commit_timing_manager_v1;
+    struct zwp_linux_dmabuf_v1                       *wp_linux_dmabuf_v1;
     struct xdg_wm_base                               *xdg_wm_base;
     struct zxdg_decoration_manager_v1                *xdg_decoration_manager_v1;
     struct zxdg_output_manager_v1                    *xdg_output_manager_v1;
@@ -43,6 +82,8 @@ struct wlf_context {
     struct ext_idle_notifier_v1                      *ext_idle_notifier_v1;
 
     struct xkb_context *xkb_context;
+    clockid_t presentation_clock;
+    struct wlf_dmabuf_state *dmabuf_feedback;
 
     void *user_data;
 };
@@ -52,3 +93,9 @@ wlf_new_id();
 
 uint32_t
 wlf_get_version(const struct wl_interface *interface, uint32_t version, uint32_t max);
+
+int
+wlf_poll(struct pollfd *fds, nfds_t nfds, int64_t timeout);
+
+int
+wlf_context_try_flush(struct wlf_context *context);
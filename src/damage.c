@@ -0,0 +1,188 @@
+#include <stdint.h>
+
+#include "damage_priv.h"
+
+static int64_t
+wlf_rect_area(struct wlf_rect r)
+{
+    return (int64_t)r.extent.width * r.extent.height;
+}
+
+static bool
+wlf_rect_touches(struct wlf_rect a, struct wlf_rect b)
+{
+    return a.offset.x <= b.offset.x + b.extent.width
+        && b.offset.x <= a.offset.x + a.extent.width
+        && a.offset.y <= b.offset.y + b.extent.height
+        && b.offset.y <= a.offset.y + a.extent.height;
+}
+
+static struct wlf_rect
+wlf_rect_bounds(struct wlf_rect a, struct wlf_rect b)
+{
+    int32_t x0 = a.offset.x < b.offset.x ? a.offset.x : b.offset.x;
+    int32_t y0 = a.offset.y < b.offset.y ? a.offset.y : b.offset.y;
+    int32_t ax1 = a.offset.x + a.extent.width;
+    int32_t ay1 = a.offset.y + a.extent.height;
+    int32_t bx1 = b.offset.x + b.extent.width;
+    int32_t by1 = b.offset.y + b.extent.height;
+    int32_t x1 = ax1 > bx1 ? ax1 : bx1;
+    int32_t y1 = ay1 > by1 ? ay1 : by1;
+
+    return (struct wlf_rect) {
+        .offset = { x0, y0 },
+        .extent = { x1 - x0, y1 - y0 },
+    };
+}
+
+static int64_t
+wlf_rect_overlap(struct wlf_rect a, struct wlf_rect b)
+{
+    int32_t x0 = a.offset.x > b.offset.x ? a.offset.x : b.offset.x;
+    int32_t y0 = a.offset.y > b.offset.y ? a.offset.y : b.offset.y;
+    int32_t ax1 = a.offset.x + a.extent.width;
+    int32_t ay1 = a.offset.y + a.extent.height;
+    int32_t bx1 = b.offset.x + b.extent.width;
+    int32_t by1 = b.offset.y + b.extent.height;
+    int32_t x1 = ax1 < bx1 ? ax1 : bx1;
+    int32_t y1 = ay1 < by1 ? ay1 : by1;
+
+    if (x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+    return (int64_t)(x1 - x0) * (y1 - y0);
+}
+
+// Area the bounding box of a and b covers beyond a and b themselves.
+static int64_t
+wlf_rect_merge_cost(struct wlf_rect a, struct wlf_rect b)
+{
+    int64_t covered = wlf_rect_area(a) + wlf_rect_area(b) - wlf_rect_overlap(a, b);
+    return wlf_rect_area(wlf_rect_bounds(a, b)) - covered;
+}
+
+void
+wlf_region_clear(struct wlf_region *region)
+{
+    region->count = 0;
+}
+
+void
+wlf_region_add(struct wlf_region *region, struct wlf_rect rect)
+{
+    if (rect.extent.width <= 0 || rect.extent.height <= 0) {
+        return;
+    }
+
+    // Touching rects are coalesced while their bounding box wastes at most a
+    // quarter of the area they cover.
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint32_t i = 0; i < region->count; ++i) {
+            struct wlf_rect r = region->rects[i];
+            if (!wlf_rect_touches(r, rect)) {
+                continue;
+            }
+
+            int64_t covered = wlf_rect_area(r) + wlf_rect_area(rect) - wlf_rect_overlap(r, rect);
+            if (wlf_rect_merge_cost(r, rect) <= covered / 4) {
+                rect = wlf_rect_bounds(r, rect);
+                region->rects[i] = region->rects[--region->count];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (region->count < WLF_REGION_MAX_RECTS) {
+        region->rects[region->count++] = rect;
+        return;
+    }
+
+    uint32_t best = 0;
+    int64_t best_cost = INT64_MAX;
+    for (uint32_t i = 0; i < region->count; ++i) {
+        int64_t cost = wlf_rect_merge_cost(region->rects[i], rect);
+        if (cost < best_cost) {
+            best = i;
+            best_cost = cost;
+        }
+    }
+
+    rect = wlf_rect_bounds(region->rects[best], rect);
+    region->rects[best] = region->rects[--region->count];
+    wlf_region_add(region, rect);
+}
+
+void
+wlf_region_union(struct wlf_region *region, const struct wlf_region *other)
+{
+    for (uint32_t i = 0; i < other->count; ++i) {
+        wlf_region_add(region, other->rects[i]);
+    }
+}
+
+void
+wlf_region_reduce(struct wlf_region *region, uint32_t max_count)
+{
+    while (region->count > max_count && region->count > 1) {
+        uint32_t best_i = 0;
+        uint32_t best_j = 1;
+        int64_t best_cost = INT64_MAX;
+        for (uint32_t i = 0; i < region->count; ++i) {
+            for (uint32_t j = i + 1; j < region->count; ++j) {
+                int64_t cost = wlf_rect_merge_cost(region->rects[i], region->rects[j]);
+                if (cost < best_cost) {
+                    best_i = i;
+                    best_j = j;
+                    best_cost = cost;
+                }
+            }
+        }
+
+        region->rects[best_i] = wlf_rect_bounds(region->rects[best_i], region->rects[best_j]);
+        region->rects[best_j] = region->rects[--region->count];
+    }
+}
+
+void
+wlf_damage_reset(struct wlf_damage *damage, struct wlf_extent extent, enum wlf_transform transform)
+{
+    damage->history_next = 0;
+    damage->history_count = 0;
+    damage->extent = extent;
+    damage->transform = transform;
+
+    wlf_region_clear(&damage->pending);
+    wlf_region_add(&damage->pending, (struct wlf_rect) { .extent = extent });
+}
+
+// Returns false when the buffer content is unknown and must be fully repainted.
+bool
+wlf_damage_get_region(const struct wlf_damage *damage, uint32_t age, struct wlf_region *region)
+{
+    if (age == 0 || age - 1 > damage->history_count) {
+        return false;
+    }
+
+    *region = damage->pending;
+    for (uint32_t i = 1; i < age; ++i) {
+        uint32_t index = (damage->history_next + WLF_DAMAGE_HISTORY - i) % WLF_DAMAGE_HISTORY;
+        wlf_region_union(region, &damage->history[index]);
+    }
+    return true;
+}
+
+void
+wlf_damage_commit(struct wlf_damage *damage)
+{
+    damage->history[damage->history_next] = damage->pending;
+    damage->history_next = (damage->history_next + 1) % WLF_DAMAGE_HISTORY;
+    if (damage->history_count < WLF_DAMAGE_HISTORY) {
+        damage->history_count++;
+    }
+
+    wlf_region_clear(&damage->pending);
+    damage->attached = false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "wlf/common.h"
+
+constexpr uint32_t WLF_REGION_MAX_RECTS = 16;
+constexpr uint32_t WLF_DAMAGE_HISTORY = 4;
+
+struct wlf_region {
+    struct wlf_rect rects[WLF_REGION_MAX_RECTS];
+    uint32_t count;
+};
+
+struct wlf_damage {
+    struct wlf_region pending;
+
+    // Damage of the most recent commits, newest first at history_next - 1.
+    struct wlf_region history[WLF_DAMAGE_HISTORY];
+    uint32_t history_next;
+    uint32_t history_count;
+
+    struct wlf_extent extent;
+    enum wlf_transform transform;
+    bool attached;
+};
+
+void
+wlf_region_clear(struct wlf_region *region);
+
+void
+wlf_region_add(struct wlf_region *region, struct wlf_rect rect);
+
+void
+wlf_region_union(struct wlf_region *region, const struct wlf_region *other);
+
+void
+wlf_region_reduce(struct wlf_region *region, uint32_t max_count);
+
+void
+wlf_damage_reset(struct wlf_damage *damage, struct wlf_extent extent, enum wlf_transform transform);
+
+bool
+wlf_damage_get_region(const struct wlf_damage *damage, uint32_t age, struct wlf_region *region);
+
+void
+wlf_damage_commit(struct wlf_damage *damage);
@@ -0,0 +1,429 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+#include <wayland-client-protocol.h>
+#include <linux-dmabuf-unstable-v1-client-protocol.h>
+
+#include "common_priv.h"
+#include "context_priv.h"
+#include "surface_priv.h"
+#include "dmabuf_priv.h"
+#include "log_priv.h"
+
+static uint64_t
+wlf_dmabuf_read_device(const struct wl_array *array)
+{
+    dev_t device = 0;
+    if (array->size == sizeof(device)) {
+        memcpy(&device, array->data, sizeof(device));
+    }
+    return (uint64_t)device;
+}
+
+static void
+wlf_dmabuf_tranches_clear(struct wl_array *tranches)
+{
+    struct wlf_dmabuf_tranche *tranche;
+    wl_array_for_each(tranche, tranches) {
+        free((void *)tranche->indices);
+    }
+    wl_array_release(tranches);
+    wl_array_init(tranches);
+}
+
+// Indices past the end of the table must be ignored.
+static void
+wlf_dmabuf_tranches_validate(struct wl_array *tranches, uint32_t format_count)
+{
+    struct wlf_dmabuf_tranche *tranche;
+    wl_array_for_each(tranche, tranches) {
+        uint16_t *indices = (uint16_t *)tranche->indices;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < tranche->index_count; ++i) {
+            if (indices[i] < format_count) {
+                indices[count++] = indices[i];
+            }
+        }
+        tranche->index_count = count;
+    }
+}
+
+// region ZWP Linux DMA-BUF Feedback
+
+static void
+zwp_linux_dmabuf_feedback_v1_done(void *data, struct zwp_linux_dmabuf_feedback_v1 *)
+{
+    struct wlf_dmabuf_state *state = data;
+
+    // The previous table stays in use unless a new one was sent.
+    if (state->pending.table) {
+        if (state->table) {
+            munmap(state->table, state->table_size);
+        }
+        state->table = state->pending.table;
+        state->table_size = state->pending.table_size;
+        state->pending.table = nullptr;
+        state->pending.table_size = 0;
+    }
+
+    uint32_t format_count = (uint32_t)(state->table_size / sizeof(struct wlf_dmabuf_format));
+    wlf_dmabuf_tranches_validate(&state->pending.tranches, format_count);
+
+    wlf_dmabuf_tranches_clear(&state->tranches);
+    state->tranches = state->pending.tranches;
+    wl_array_init(&state->pending.tranches);
+
+    state->current = (struct wlf_dmabuf_feedback) {
+        .main_device = state->pending.main_device,
+        .formats = state->table,
+        .format_count = format_count,
+        .tranches = state->tranches.data,
+        .tranche_count = (uint32_t)(state->tranches.size / sizeof(struct wlf_dmabuf_tranche)),
+    };
+    state->received = true;
+
+    if (state->surface) {
+        struct wlf_surface *surface = state->surface;
+        if (surface->listener.dmabuf_feedback) {
+            surface->listener.dmabuf_feedback(surface->user_data, &state->current);
+        }
+    } else {
+        struct wlf_context *context = state->context;
+        if (context->listener.dmabuf_feedback) {
+            context->listener.dmabuf_feedback(context->user_data, &state->current);
+        }
+    }
+}
+
+// The table is mapped read-only and handed out as is.
+static void
+zwp_linux_dmabuf_feedback_v1_format_table(
+    void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *,
+    int32_t fd,
+    uint32_t size)
+{
+    struct wlf_dmabuf_state *state = data;
+
+    void *table = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (table == MAP_FAILED) {
+        wlf_error("Failed to map dmabuf format table.\n");
+        return;
+    }
+
+    if (state->pending.table) {
+        munmap(state->pending.table, state->pending.table_size);
+    }
+    state->pending.table = table;
+    state->pending.table_size = size;
+}
+
+static void
+zwp_linux_dmabuf_feedback_v1_main_device(
+    void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *,
+    struct wl_array *device)
+{
+    struct wlf_dmabuf_state *state = data;
+    state->pending.main_device = wlf_dmabuf_read_device(device);
+}
+
+static void
+zwp_linux_dmabuf_feedback_v1_tranche_done(void *data, struct zwp_linux_dmabuf_feedback_v1 *)
+{
+    struct wlf_dmabuf_state *state = data;
+
+    struct wlf_dmabuf_tranche *tranche = wl_array_add(&state->pending.tranches, sizeof(*tranche));
+    if (!tranche) {
+        free((void *)state->pending.tranche.indices);
+    } else {
+        *tranche = state->pending.tranche;
+    }
+    state->pending.tranche = (struct wlf_dmabuf_tranche) {};
+}
+
+static void
+zwp_linux_dmabuf_feedback_v1_tranche_target_device(
+    void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *,
+    struct wl_array *device)
+{
+    struct wlf_dmabuf_state *state = data;
+    state->pending.tranche.device = wlf_dmabuf_read_device(device);
+}
+
+static void
+zwp_linux_dmabuf_feedback_v1_tranche_formats(
+    void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *,
+    struct wl_array *indices)
+{
+    struct wlf_dmabuf_state *state = data;
+    struct wlf_dmabuf_tranche *tranche = &state->pending.tranche;
+
+    uint16_t *copy = malloc(indices->size ? indices->size : 1);
+    if (!copy) {
+        return;
+    }
+    memcpy(copy, indices->data, indices->size);
+
+    free((void *)tranche->indices);
+    tranche->indices = copy;
+    tranche->index_count = (uint32_t)(indices->size / sizeof(uint16_t));
+}
+
+static void
+zwp_linux_dmabuf_feedback_v1_tranche_flags(
+    void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *,
+    uint32_t flags)
+{
+    struct wlf_dmabuf_state *state = data;
+    state->pending.tranche.flags = flags & ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT
+                                 ? WLF_DMABUF_TRANCHE_FLAGS_SCANOUT
+                                 : WLF_DMABUF_TRANCHE_FLAGS_NONE;
+}
+
+static const struct zwp_linux_dmabuf_feedback_v1_listener zwp_linux_dmabuf_feedback_v1_listener = {
+    .done                  = zwp_linux_dmabuf_feedback_v1_done,
+    .format_table          = zwp_linux_dmabuf_feedback_v1_format_table,
+    .main_device           = zwp_linux_dmabuf_feedback_v1_main_device,
+    .tranche_done          = zwp_linux_dmabuf_feedback_v1_tranche_done,
+    .tranche_target_device = zwp_linux_dmabuf_feedback_v1_tranche_target_device,
+    .tranche_formats       = zwp_linux_dmabuf_feedback_v1_tranche_formats,
+    .tranche_flags         = zwp_linux_dmabuf_feedback_v1_tranche_flags,
+};
+
+// endregion
+
+// A null surface tracks the default feedback of the context.
+struct wlf_dmabuf_state *
+wlf_dmabuf_state_create(struct wlf_context *context, struct wlf_surface *surface)
+{
+    struct wlf_dmabuf_state *state = calloc(1, sizeof(*state));
+    if (!state) {
+        return nullptr;
+    }
+    state->context = context;
+    state->surface = surface;
+    wl_array_init(&state->tranches);
+    wl_array_init(&state->pending.tranches);
+
+    if (surface) {
+        struct zwp_linux_dmabuf_v1 *dmabuf = wlf_surface_wrap_proxy(surface, context->wp_linux_dmabuf_v1);
+        if (dmabuf) {
+            state->wp_feedback = zwp_linux_dmabuf_v1_get_surface_feedback(dmabuf, surface->wl_surface);
+            wlf_surface_unwrap_proxy(surface, dmabuf);
+        }
+    } else {
+        state->wp_feedback = zwp_linux_dmabuf_v1_get_default_feedback(context->wp_linux_dmabuf_v1);
+    }
+
+    if (!state->wp_feedback) {
+        free(state);
+        return nullptr;
+    }
+
+    zwp_linux_dmabuf_feedback_v1_add_listener(
+        state->wp_feedback,
+        &zwp_linux_dmabuf_feedback_v1_listener,
+        state);
+    return state;
+}
+
+void
+wlf_dmabuf_state_destroy(struct wlf_dmabuf_state *state)
+{
+    zwp_linux_dmabuf_feedback_v1_destroy(state->wp_feedback);
+
+    if (state->table) {
+        munmap(state->table, state->table_size);
+    }
+    if (state->pending.table) {
+        munmap(state->pending.table, state->pending.table_size);
+    }
+
+    free((void *)state->pending.tranche.indices);
+    wlf_dmabuf_tranches_clear(&state->pending.tranches);
+    wlf_dmabuf_tranches_clear(&state->tranches);
+    free(state);
+}
+
+// region WL Buffer
+
+static void
+wl_buffer_release(void *data, struct wl_buffer *)
+{
+    struct wlf_dmabuf_buffer *buffer = data;
+    atomic_store_explicit(&buffer->busy, false, memory_order_release);
+}
+
+static const struct wl_buffer_listener wl_buffer_listener = {
+    .release = wl_buffer_release,
+};
+
+// endregion
+
+// region Public API
+
+// Feedback is only available from version 4 on; until the first done event
+// arrives WLF_PENDING is returned.
+enum wlf_result
+wlf_context_get_dmabuf_feedback(struct wlf_context *context, const struct wlf_dmabuf_feedback **feedback)
+{
+    struct zwp_linux_dmabuf_v1 *dmabuf = context->wp_linux_dmabuf_v1;
+    if (!dmabuf ||
+        zwp_linux_dmabuf_v1_get_version(dmabuf) < ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION)
+    {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (!context->dmabuf_feedback) {
+        context->dmabuf_feedback = wlf_dmabuf_state_create(context, nullptr);
+        if (!context->dmabuf_feedback) {
+            return WLF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (!context->dmabuf_feedback->received) {
+        return WLF_PENDING;
+    }
+    *feedback = &context->dmabuf_feedback->current;
+    return WLF_SUCCESS;
+}
+
+// Surface feedback follows where the surface is shown, e.g. a fullscreen
+// surface may get a scanout tranche. Changes are reported through the
+// dmabuf_feedback surface listener.
+enum wlf_result
+wlf_surface_get_dmabuf_feedback(struct wlf_surface *surface, const struct wlf_dmabuf_feedback **feedback)
+{
+    struct wlf_context *context = surface->context;
+    struct zwp_linux_dmabuf_v1 *dmabuf = context->wp_linux_dmabuf_v1;
+    if (!dmabuf ||
+        zwp_linux_dmabuf_v1_get_version(dmabuf) < ZWP_LINUX_DMABUF_V1_GET_SURFACE_FEEDBACK_SINCE_VERSION)
+    {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (!surface->dmabuf_feedback) {
+        surface->dmabuf_feedback = wlf_dmabuf_state_create(context, surface);
+        if (!surface->dmabuf_feedback) {
+            return WLF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (!surface->dmabuf_feedback->received) {
+        return WLF_PENDING;
+    }
+    *feedback = &surface->dmabuf_feedback->current;
+    return WLF_SUCCESS;
+}
+
+// The fds stay owned by the caller. Attributes the compositor rejects are a
+// protocol error, so format and modifier should come from the feedback.
+enum wlf_result
+wlf_dmabuf_buffer_create(
+    struct wlf_context *context,
+    const struct wlf_dmabuf_attributes *attributes,
+    struct wlf_dmabuf_buffer **_buffer)
+{
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+    struct zwp_linux_dmabuf_v1 *dmabuf = context->wp_linux_dmabuf_v1;
+    if (!dmabuf ||
+        zwp_linux_dmabuf_v1_get_version(dmabuf) < ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION)
+    {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    const struct wlf_extent extent = attributes->extent;
+    if (extent.width <= 0 || extent.height <= 0 ||
+        attributes->plane_count == 0 || attributes->plane_count > 4)
+    {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+    for (uint32_t i = 0; i < attributes->plane_count; ++i) {
+        if (attributes->planes[i].fd < 0) {
+            return WLF_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    struct wlf_dmabuf_buffer *buffer = calloc(1, sizeof(*buffer));
+    if (!buffer) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    struct zwp_linux_buffer_params_v1 *params = zwp_linux_dmabuf_v1_create_params(dmabuf);
+    if (!params) {
+        free(buffer);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint32_t modifier_hi = (uint32_t)(attributes->modifier >> 32);
+    uint32_t modifier_lo = (uint32_t)(attributes->modifier & 0xffff'ffff);
+    for (uint32_t i = 0; i < attributes->plane_count; ++i) {
+        const struct wlf_dmabuf_plane *plane = &attributes->planes[i];
+        zwp_linux_buffer_params_v1_add(
+            params,
+            plane->fd,
+            i,
+            plane->offset,
+            plane->stride,
+            modifier_hi,
+            modifier_lo);
+    }
+
+    buffer->wl_buffer = zwp_linux_buffer_params_v1_create_immed(
+        params,
+        extent.width,
+        extent.height,
+        attributes->format,
+        0);
+    zwp_linux_buffer_params_v1_destroy(params);
+
+    if (!buffer->wl_buffer) {
+        free(buffer);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    wl_buffer_add_listener(buffer->wl_buffer, &wl_buffer_listener, buffer);
+    buffer->extent = extent;
+
+    *_buffer = buffer;
+    return WLF_SUCCESS;
+}
+
+void
+wlf_dmabuf_buffer_destroy(struct wlf_dmabuf_buffer *buffer)
+{
+    wl_buffer_destroy(buffer->wl_buffer);
+    free(buffer);
+}
+
+bool
+wlf_dmabuf_buffer_is_busy(struct wlf_dmabuf_buffer *buffer)
+{
+    return atomic_load_explicit(&buffer->busy, memory_order_acquire);
+}
+
+enum wlf_result
+wlf_surface_attach_dmabuf_buffer(struct wlf_surface *surface, struct wlf_dmabuf_buffer *buffer)
+{
+    if (atomic_load_explicit(&buffer->busy, memory_order_acquire)) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    wl_surface_attach(surface->wl_surface, buffer->wl_buffer, 0, 0);
+    surface->damage.attached = true;
+
+    atomic_store_explicit(&buffer->busy, true, memory_order_relaxed);
+    return WLF_SUCCESS;
+}
+
+// endregion
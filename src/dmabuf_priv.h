@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include <wayland-util.h>
+
+#include "wlf/dmabuf.h"
+
+struct wlf_dmabuf_buffer {
+    struct wl_buffer *wl_buffer;
+    struct wlf_extent extent;
+
+    // Held by the compositor until wl_buffer.release, which is dispatched on
+    // the default queue and possibly another thread.
+    atomic_bool busy;
+};
+
+// Tracks one zwp_linux_dmabuf_feedback_v1 object. The published feedback
+// points into the mapped format table and stays valid until the next done
+// event replaces it.
+struct wlf_dmabuf_state {
+    struct wlf_context *context;
+    struct wlf_surface *surface;
+    struct zwp_linux_dmabuf_feedback_v1 *wp_feedback;
+
+    struct wlf_dmabuf_feedback current;
+    bool received;
+    void *table;
+    size_t table_size;
+    struct wl_array tranches;
+
+    struct {
+        void *table;
+        size_t table_size;
+        uint64_t main_device;
+        struct wlf_dmabuf_tranche tranche;
+        struct wl_array tranches;
+    } pending;
+};
+
+struct wlf_dmabuf_state *
+wlf_dmabuf_state_create(struct wlf_context *context, struct wlf_surface *surface);
+
+void
+wlf_dmabuf_state_destroy(struct wlf_dmabuf_state *state);
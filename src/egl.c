@@ -42,6 +42,52 @@ wlfCreateEGLSurface(
     return egl;
 }
 
+EGLBoolean
+wlfSwapEGLBuffersAt(
+    PFNEGLSWAPBUFFERSPROC proc,
+    EGLDisplay display,
+    struct wlf_surface *surface,
+    EGLSurface egl_surface,
+    int64_t present_time)
+{
+    if (surface->fifo && surface->context->wp_fifo_manager_v1) {
+        wlf_surface_wait_fifo_barrier(surface);
+        wlf_surface_set_fifo_barrier(surface);
+    }
+
+    if (present_time > 0 && surface->context->wp_commit_timing_manager_v1) {
+        wlf_surface_set_present_time(surface, present_time);
+    }
+
+    wlf_surface_ack_configure(surface);
+    return proc(display, egl_surface);
+}
+
+EGLBoolean
+wlfSwapEGLBuffersWithDamage(
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC proc,
+    EGLDisplay display,
+    struct wlf_surface *surface,
+    EGLSurface egl_surface)
+{
+    struct wlf_region region;
+    wlf_surface_take_damage(surface, &region);
+
+    // EGL damage rects have their origin in the bottom-left corner.
+    EGLint rects[4 * WLF_REGION_MAX_RECTS];
+    int32_t height = surface->damage.extent.height;
+    for (uint32_t i = 0; i < region.count; ++i) {
+        const struct wlf_rect *r = &region.rects[i];
+        rects[i * 4 + 0] = r->offset.x;
+        rects[i * 4 + 1] = height - r->offset.y - r->extent.height;
+        rects[i * 4 + 2] = r->extent.width;
+        rects[i * 4 + 3] = r->extent.height;
+    }
+
+    wlf_surface_ack_configure(surface);
+    return proc(display, egl_surface, rects, (EGLint)region.count);
+}
+
 void
 wlfDestroyEGLSurface(
     PFNEGLDESTROYSURFACEPROC proc,
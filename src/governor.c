@@ -0,0 +1,59 @@
+#include "governor_priv.h"
+
+// Samples averaged after a change before the governor steps again, so the
+// cost of the new resolution is known before it is judged.
+constexpr uint32_t WLF_GOVERNOR_SETTLE = 16;
+
+void
+wlf_governor_init(struct wlf_governor *governor)
+{
+    governor->scale = WLF_GOVERNOR_MAX_SCALE;
+    governor->average = 0;
+    governor->samples = 0;
+}
+
+// Rendering cost is taken to grow with the pixel count, i.e. the square of
+// the scale.
+static int64_t
+wlf_governor_predict(const struct wlf_governor *governor, uint32_t scale)
+{
+    int64_t num = (int64_t)scale * scale;
+    int64_t den = (int64_t)governor->scale * governor->scale;
+    return governor->average * num / den;
+}
+
+// Returns true when the render scale changed.
+bool
+wlf_governor_update(struct wlf_governor *governor, int64_t frame_time, int64_t target)
+{
+    if (governor->samples == 0) {
+        governor->average = frame_time;
+    } else {
+        governor->average += (frame_time - governor->average) / 8;
+    }
+
+    if (++governor->samples < WLF_GOVERNOR_SETTLE) {
+        return false;
+    }
+
+    uint32_t scale = governor->scale;
+    if (governor->average > target && scale > WLF_GOVERNOR_MIN_SCALE) {
+        scale -= WLF_GOVERNOR_STEP;
+    } else if (scale < WLF_GOVERNOR_MAX_SCALE) {
+        // Step up only with headroom left, otherwise the governor would
+        // oscillate around the target.
+        uint32_t next = scale + WLF_GOVERNOR_STEP;
+        if (wlf_governor_predict(governor, next) < target - target / 8) {
+            scale = next;
+        }
+    }
+
+    if (scale == governor->scale) {
+        return false;
+    }
+
+    governor->average = wlf_governor_predict(governor, scale);
+    governor->scale = scale;
+    governor->samples = 1;
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "wlf/common.h"
+
+constexpr uint32_t WLF_GOVERNOR_MIN_SCALE = 50;
+constexpr uint32_t WLF_GOVERNOR_MAX_SCALE = 100;
+constexpr uint32_t WLF_GOVERNOR_STEP = 10;
+
+struct wlf_governor {
+    // Render resolution in percent of the full buffer extent.
+    uint32_t scale;
+
+    int64_t average;
+    uint32_t samples;
+};
+
+void
+wlf_governor_init(struct wlf_governor *governor);
+
+bool
+wlf_governor_update(struct wlf_governor *governor, int64_t frame_time, int64_t target);
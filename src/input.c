@@ -28,6 +28,9 @@
 #include "context_priv.h"
 #include "surface_priv.h"
 #include "input_priv.h"
+#include "loop_priv.h"
+#include "trace_priv.h"
+#include "log_priv.h"
 
 constexpr uint32_t WLF_WL_SEAT_VERSION = 9;
 
@@ -718,7 +721,9 @@ wlf_seat_init_pointer(struct wlf_seat *seat)
     seat->pointer.wl_pointer = wl_seat_get_pointer(seat->wl_seat);
     wl_pointer_add_listener(seat->pointer.wl_pointer, &wl_pointer_listener, &seat->pointer);
 
+    wlf_trace_begin(ctx, WLF_TIMING_CURSOR_THEME);
     seat->pointer.cursor.theme = wl_cursor_theme_load(theme, size, ctx->wl_shm);
+    wlf_trace_end(ctx, WLF_TIMING_CURSOR_THEME);
     seat->pointer.cursor.surface = wl_compositor_create_surface(ctx->wl_compositor);
     seat->pointer.cursor.last = -1;
 
@@ -841,6 +846,14 @@ static const struct zwp_input_timestamps_v1_listener wp_keyboard_timestamps_v1_l
 
 // region Wl Keyboard
 
+[[maybe_unused]]
+static inline struct wlf_context *
+wlf_keyboard_get_context(struct wlf_keyboard *keyboard)
+{
+    struct wlf_seat *seat = wl_container_of(keyboard, seat, keyboard);
+    return seat->global.context;
+}
+
 static void
 wl_keyboard_keymap(
     void *data,
@@ -868,11 +881,13 @@ wl_keyboard_keymap(
         return;
     }
 
+    wlf_trace_begin(wlf_keyboard_get_context(keyboard), WLF_TIMING_KEYMAP);
     struct xkb_keymap *keymap = xkb_keymap_new_from_string(
         keyboard->xkb_context,
         map_str,
         XKB_KEYMAP_FORMAT_TEXT_V1,
         XKB_KEYMAP_COMPILE_NO_FLAGS);
+    wlf_trace_end(wlf_keyboard_get_context(keyboard), WLF_TIMING_KEYMAP);
     munmap(map_str, size);
     if (!keymap) {
         return;
@@ -900,6 +915,38 @@ wl_keyboard_keymap(
     keyboard->xkb_state = state;
 }
 
+static void
+wlf_keyboard_stop_repeat(struct wlf_keyboard *keyboard)
+{
+    if (keyboard->repeat_key != 0) {
+        wlf_source_arm_timer(keyboard->repeat_source, -1, 0);
+        keyboard->repeat_key = 0;
+    }
+}
+
+static void
+wlf_keyboard_emit_key(struct wlf_keyboard *keyboard, uint32_t key, enum wlf_key_state state)
+{
+    struct wlf_seat *seat = wl_container_of(keyboard, seat, keyboard);
+    if (!seat->listener.key) {
+        return;
+    }
+
+    xkb_keysym_t sym = xkb_state_key_get_one_sym(keyboard->xkb_state, key + 8);
+    seat->listener.key(seat->user_data, keyboard->focus, sym, state);
+}
+
+static void
+wlf_keyboard_repeat(void *data)
+{
+    struct wlf_keyboard *keyboard = data;
+
+    if (keyboard->repeat_key == 0 || !keyboard->xkb_state) {
+        return;
+    }
+    wlf_keyboard_emit_key(keyboard, keyboard->repeat_key, WLF_KEY_STATE_REPEATED);
+}
+
 static void
 wl_keyboard_enter(
     void *data,
@@ -908,6 +955,8 @@ wl_keyboard_enter(
     struct wl_surface *wl_surface,
     struct wl_array *keys)
 {
+    struct wlf_keyboard *keyboard = data;
+    keyboard->focus = wl_surface ? wl_surface_get_user_data(wl_surface) : nullptr;
 }
 
 static void
@@ -917,6 +966,9 @@ wl_keyboard_leave(
     uint32_t serial,
     struct wl_surface *wl_surface)
 {
+    struct wlf_keyboard *keyboard = data;
+    wlf_keyboard_stop_repeat(keyboard);
+    keyboard->focus = nullptr;
 }
 
 static void
@@ -928,6 +980,35 @@ wl_keyboard_key(
     uint32_t key,
     uint32_t state)
 {
+    struct wlf_keyboard *keyboard = data;
+
+    if (!keyboard->xkb_state) {
+        return;
+    }
+
+    if (state == WL_KEYBOARD_KEY_STATE_RELEASED) {
+        if (key == keyboard->repeat_key) {
+            wlf_keyboard_stop_repeat(keyboard);
+        }
+        wlf_keyboard_emit_key(keyboard, key, WLF_KEY_STATE_RELEASED);
+        return;
+    }
+
+    wlf_keyboard_emit_key(keyboard, key, WLF_KEY_STATE_PRESSED);
+
+    struct xkb_keymap *keymap = xkb_state_get_keymap(keyboard->xkb_state);
+    if (keyboard->repeat_rate <= 0 ||
+        !keyboard->repeat_source ||
+        !xkb_keymap_key_repeats(keymap, key + 8))
+    {
+        return;
+    }
+
+    keyboard->repeat_key = key;
+    wlf_source_arm_timer(
+        keyboard->repeat_source,
+        wlf_ms_to_ns((uint32_t)keyboard->repeat_delay),
+        1'000'000'000 / keyboard->repeat_rate);
 }
 
 static void
@@ -965,6 +1046,10 @@ wl_keyboard_repeat_info(
 
     keyboard->repeat_rate = rate;
     keyboard->repeat_delay = delay;
+
+    if (rate <= 0) {
+        wlf_keyboard_stop_repeat(keyboard);
+    }
 }
 
 static const struct wl_keyboard_listener wl_keyboard_listener = {
@@ -1003,6 +1088,17 @@ wlf_seat_init_keyboard(struct wlf_seat *seat)
     seat->keyboard.locale = setlocale(LC_CTYPE_MASK, nullptr);
 
     seat->keyboard.event_time = -1;
+
+    // Default repeat info for wl_keyboard versions without the repeat_info event.
+    seat->keyboard.repeat_rate = 25;
+    seat->keyboard.repeat_delay = 600;
+    seat->keyboard.repeat_source = wlf_loop_add_timer(
+        &ctx->loop,
+        wlf_keyboard_repeat,
+        &seat->keyboard);
+    if (!seat->keyboard.repeat_source) {
+        wlf_warn("Failed to create key repeat timer.\n");
+    }
 }
 
 static void
@@ -1011,6 +1107,10 @@ wlf_seat_fini_keyboard(struct wlf_seat *seat)
     struct wlf_keyboard *keyboard = &seat->keyboard;
     assert(keyboard->wl_keyboard);
 
+    if (keyboard->repeat_source) {
+        wlf_source_remove(keyboard->repeat_source);
+    }
+
     if (keyboard->wp_timestamps_v1) {
         zwp_input_timestamps_v1_destroy(keyboard->wp_timestamps_v1);
     }
@@ -1603,6 +1703,11 @@ wlf_seat_handle_surface_destroyed(struct wlf_seat *seat, struct wlf_surface *sur
     if (constraint) {
         wlf_pointer_constraint_destroy(constraint);
     }
+
+    if (seat->keyboard.focus == surface) {
+        wlf_keyboard_stop_repeat(&seat->keyboard);
+        seat->keyboard.focus = nullptr;
+    }
 }
 
 struct wlf_seat *
@@ -1668,6 +1773,13 @@ wlf_seat_bind(
     const struct wlf_seat_listener *listener,
     struct wlf_seat **_seat)
 {
+    if (!context->ready) {
+        return WLF_ERROR_UNINITIALIZED;
+    }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+
     struct wlf_seat *seat = wlf_seat_find(context, info->id);
     if (!seat) {
         return WLF_ERROR_LOST;
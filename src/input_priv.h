@@ -99,6 +99,10 @@ struct wlf_keyboard {
 
     const char *locale;
 
+    struct wlf_surface *focus;
+    struct wlf_source  *repeat_source;
+    uint32_t repeat_key;
+
     int32_t repeat_rate;
     int32_t repeat_delay;
     int64_t event_time;
@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "common_priv.h"
+#include "context_priv.h"
+#include "loop_priv.h"
+#include "log_priv.h"
+
+constexpr int WLF_LOOP_MAX_EVENTS = 32;
+
+static uint32_t
+wlf_source_events_to_epoll(enum wlf_source_events events)
+{
+    uint32_t out = 0;
+    if (events & WLF_SOURCE_EVENTS_READABLE) {
+        out |= EPOLLIN;
+    }
+    if (events & WLF_SOURCE_EVENTS_WRITABLE) {
+        out |= EPOLLOUT;
+    }
+    return out;
+}
+
+static enum wlf_source_events
+wlf_source_events_from_epoll(uint32_t events)
+{
+    enum wlf_source_events out = WLF_SOURCE_EVENTS_NONE;
+    if (events & EPOLLIN) {
+        out |= WLF_SOURCE_EVENTS_READABLE;
+    }
+    if (events & EPOLLOUT) {
+        out |= WLF_SOURCE_EVENTS_WRITABLE;
+    }
+    if (events & EPOLLHUP) {
+        out |= WLF_SOURCE_EVENTS_HANGUP;
+    }
+    if (events & EPOLLERR) {
+        out |= WLF_SOURCE_EVENTS_ERROR;
+    }
+    return out;
+}
+
+static struct wlf_source *
+wlf_loop_add_source(
+    struct wlf_loop *loop,
+    enum wlf_source_type type,
+    int fd,
+    enum wlf_source_events events)
+{
+    struct wlf_source *source = calloc(1, sizeof(struct wlf_source));
+    if (!source) {
+        return nullptr;
+    }
+
+    source->loop = loop;
+    source->type = type;
+    source->fd = fd;
+    source->events = events;
+
+    struct epoll_event ev = {
+        .events = wlf_source_events_to_epoll(events),
+        .data.ptr = source,
+    };
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        wlf_error("Failed to add fd %i to event loop.\n", fd);
+        free(source);
+        return nullptr;
+    }
+
+    wl_list_insert(&loop->source_list, &source->link);
+    return source;
+}
+
+static void
+wlf_source_destroy(struct wlf_source *source)
+{
+    wl_list_remove(&source->link);
+    if (source->type == WLF_SOURCE_TYPE_TIMER) {
+        close(source->fd);
+    }
+    free(source);
+}
+
+static void
+wlf_source_dispatch(struct wlf_source *source, uint32_t events)
+{
+    if (source->type == WLF_SOURCE_TYPE_TIMER) {
+        uint64_t expirations;
+        ssize_t n;
+        do {
+            n = read(source->fd, &expirations, sizeof(expirations));
+        } while (n < 0 && errno == EINTR);
+
+        // The timer was re-armed or disarmed after it expired.
+        if (n < 0) {
+            return;
+        }
+        source->timer_func(source->user_data);
+    } else {
+        source->fd_func(source->user_data, source->fd, wlf_source_events_from_epoll(events));
+    }
+}
+
+enum wlf_result
+wlf_loop_init(struct wlf_loop *loop)
+{
+    wl_list_init(&loop->source_list);
+    wl_list_init(&loop->removed_list);
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) {
+        wlf_error("Failed to create epoll fd.\n");
+        return WLF_ERROR_UNKNOWN;
+    }
+    return WLF_SUCCESS;
+}
+
+void
+wlf_loop_fini(struct wlf_loop *loop)
+{
+    assert(loop->depth == 0);
+
+    struct wlf_source *source, *tmp;
+    wl_list_for_each_safe(source, tmp, &loop->source_list, link) {
+        wlf_source_destroy(source);
+    }
+    close(loop->epoll_fd);
+}
+
+struct wlf_source *
+wlf_loop_add_fd(
+    struct wlf_loop *loop,
+    int fd,
+    enum wlf_source_events events,
+    wlf_fd_func_t func,
+    void *user_data)
+{
+    struct wlf_source *source = wlf_loop_add_source(loop, WLF_SOURCE_TYPE_FD, fd, events);
+    if (source) {
+        source->fd_func = func;
+        source->user_data = user_data;
+    }
+    return source;
+}
+
+struct wlf_source *
+wlf_loop_add_timer(struct wlf_loop *loop, wlf_timer_func_t func, void *user_data)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        wlf_error("Failed to create timerfd.\n");
+        return nullptr;
+    }
+
+    struct wlf_source *source = wlf_loop_add_source(
+        loop, WLF_SOURCE_TYPE_TIMER, fd, WLF_SOURCE_EVENTS_READABLE);
+    if (!source) {
+        close(fd);
+        return nullptr;
+    }
+
+    source->timer_func = func;
+    source->user_data = user_data;
+    return source;
+}
+
+int
+wlf_loop_dispatch(struct wlf_loop *loop)
+{
+    struct epoll_event events[WLF_LOOP_MAX_EVENTS];
+
+    int n;
+    do {
+        n = epoll_wait(loop->epoll_fd, events, WLF_LOOP_MAX_EVENTS, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return n;
+    }
+
+    // Sources removed by a callback are kept alive until the whole
+    // batch is dispatched, as later events may still point to them.
+    loop->depth++;
+    for (int i = 0; i < n; i++) {
+        struct wlf_source *source = events[i].data.ptr;
+        if (!source->removed) {
+            wlf_source_dispatch(source, events[i].events);
+        }
+    }
+    loop->depth--;
+
+    if (loop->depth == 0) {
+        struct wlf_source *source, *tmp;
+        wl_list_for_each_safe(source, tmp, &loop->removed_list, link) {
+            wlf_source_destroy(source);
+        }
+    }
+
+    return n;
+}
+
+// region Public API
+
+enum wlf_result
+wlf_context_add_fd(
+    struct wlf_context *context,
+    int fd,
+    enum wlf_source_events events,
+    wlf_fd_func_t func,
+    void *user_data,
+    struct wlf_source **_source)
+{
+    if (fd < 0 || !func) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct wlf_source *source = wlf_loop_add_fd(&context->loop, fd, events, func, user_data);
+    if (!source) {
+        return WLF_ERROR_UNKNOWN;
+    }
+
+    *_source = source;
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_context_add_timer(
+    struct wlf_context *context,
+    wlf_timer_func_t func,
+    void *user_data,
+    struct wlf_source **_source)
+{
+    if (!func) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct wlf_source *source = wlf_loop_add_timer(&context->loop, func, user_data);
+    if (!source) {
+        return WLF_ERROR_UNKNOWN;
+    }
+
+    *_source = source;
+    return WLF_SUCCESS;
+}
+
+int
+wlf_context_get_loop_fd(struct wlf_context *context)
+{
+    return context->loop.epoll_fd;
+}
+
+enum wlf_result
+wlf_context_dispatch_sources(struct wlf_context *context)
+{
+    return wlf_loop_dispatch(&context->loop) < 0 ? WLF_ERROR_UNKNOWN : WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_source_set_events(struct wlf_source *source, enum wlf_source_events events)
+{
+    if (source->type != WLF_SOURCE_TYPE_FD) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (source->events == events) {
+        return WLF_SKIPPED;
+    }
+
+    struct epoll_event ev = {
+        .events = wlf_source_events_to_epoll(events),
+        .data.ptr = source,
+    };
+    if (epoll_ctl(source->loop->epoll_fd, EPOLL_CTL_MOD, source->fd, &ev) < 0) {
+        return WLF_ERROR_UNKNOWN;
+    }
+
+    source->events = events;
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_source_arm_timer(struct wlf_source *source, int64_t delay, int64_t interval)
+{
+    if (source->type != WLF_SOURCE_TYPE_TIMER) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct itimerspec its = {};
+    if (delay >= 0) {
+        // A zero it_value disarms the timer, so fire after 1ns instead.
+        its.it_value = wlf_ns_to_timespec(delay > 0 ? delay : 1);
+        if (interval > 0) {
+            its.it_interval = wlf_ns_to_timespec(interval);
+        }
+    }
+
+    if (timerfd_settime(source->fd, 0, &its, nullptr) < 0) {
+        return WLF_ERROR_UNKNOWN;
+    }
+    return WLF_SUCCESS;
+}
+
+void
+wlf_source_remove(struct wlf_source *source)
+{
+    struct wlf_loop *loop = source->loop;
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, source->fd, nullptr);
+
+    if (loop->depth > 0) {
+        source->removed = true;
+        wl_list_remove(&source->link);
+        wl_list_insert(&loop->removed_list, &source->link);
+        return;
+    }
+
+    wlf_source_destroy(source);
+}
+
+// endregion
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <wayland-util.h>
+
+#include "wlf/loop.h"
+
+enum wlf_source_type : uint32_t {
+    WLF_SOURCE_TYPE_FD = 1,
+    WLF_SOURCE_TYPE_TIMER = 2,
+};
+
+struct wlf_source {
+    struct wlf_loop *loop;
+    struct wl_list link;
+
+    enum wlf_source_type type;
+    enum wlf_source_events events;
+    int fd;
+    bool removed;
+
+    union {
+        wlf_fd_func_t fd_func;
+        wlf_timer_func_t timer_func;
+    };
+    void *user_data;
+};
+
+struct wlf_loop {
+    int epoll_fd;
+    int depth;
+
+    struct wl_list source_list;
+    struct wl_list removed_list;
+};
+
+enum wlf_result
+wlf_loop_init(struct wlf_loop *loop);
+
+void
+wlf_loop_fini(struct wlf_loop *loop);
+
+struct wlf_source *
+wlf_loop_add_fd(
+    struct wlf_loop *loop,
+    int fd,
+    enum wlf_source_events events,
+    wlf_fd_func_t func,
+    void *user_data);
+
+struct wlf_source *
+wlf_loop_add_timer(struct wlf_loop *loop, wlf_timer_func_t func, void *user_data);
+
+int
+wlf_loop_dispatch(struct wlf_loop *loop);
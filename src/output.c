@@ -5,6 +5,7 @@
 #include <wayland-client-protocol.h>
 #include <xdg-output-unstable-v1-client-protocol.h>
 
+#include "common_priv.h"
 #include "context_priv.h"
 #include "output_priv.h"
 #include "surface_priv.h"
@@ -22,64 +23,46 @@ wlf_output_get_scale(struct wlf_output *output)
     return output->scale;
 }
 
+// Estimated in 120ths from the mode and the logical size, which only
+// differ by the compositor-side scale.
 int32_t
-wlf_output_ref_list_get_max_scale(const struct wl_list *list)
+wlf_output_get_fractional_scale(struct wlf_output *output)
 {
-    int32_t max_scale = 1;
-
-    struct wlf_output_ref *ref;
-    wl_list_for_each(ref, list, link) {
-        int32_t scale = wlf_output_get_scale(ref->output);
-        if (scale > max_scale) {
-            max_scale = scale;
-        }
+    int32_t logical = output->logical.width;
+    int32_t pixel = wlf_transform_is_vertical(output->transform)
+                  ? output->pixel.height
+                  : output->pixel.width;
+    if (logical <= 0 || pixel <= 0) {
+        return wlf_output_get_scale(output) * 120;
     }
-
-    return max_scale;
-}
-
-struct wlf_output_ref *
-wlf_output_ref_list_find(const struct wl_list *list, struct wlf_output *output)
-{
-    struct wlf_output_ref *ref;
-    wl_list_for_each(ref, list, link) {
-        if (ref->output == output) {
-            return ref;
-        }
-    }
-
-    return nullptr;
+    return wlf_div_round(pixel * 120, logical);
 }
 
 bool
-wlf_output_ref_list_add(struct wl_list *list, struct wlf_output *output)
+wlf_output_add_surface(struct wlf_output *output, struct wlf_surface *surface)
 {
-    struct wlf_output_ref *ref = wlf_output_ref_list_find(list, output);
-    if (ref) {
-        return false;
-    }
-
-    ref = calloc(1, sizeof(*ref));
-    if (!ref) {
+    struct wlf_surface **entry = wl_array_add(&output->surfaces, sizeof(*entry));
+    if (!entry) {
         return false;
     }
 
-    ref->output = output;
-    wl_list_insert(list, &ref->link);
+    *entry = surface;
+    surface->output_index[output->slot] =
+        (uint32_t)(entry - (struct wlf_surface **)output->surfaces.data);
     return true;
 }
 
-bool
-wlf_output_ref_list_remove(struct wl_list *list, struct wlf_output *output)
+void
+wlf_output_remove_surface(struct wlf_output *output, struct wlf_surface *surface)
 {
-    struct wlf_output_ref *ref = wlf_output_ref_list_find(list, output);
-    if (!ref) {
-        return false;
-    }
-
-    wl_list_remove(&ref->link);
-    free(ref);
-    return true;
+    struct wlf_surface **surfaces = output->surfaces.data;
+    size_t count = output->surfaces.size / sizeof(*surfaces);
+    uint32_t index = surface->output_index[output->slot];
+
+    struct wlf_surface *last = surfaces[count - 1];
+    surfaces[index] = last;
+    last->output_index[output->slot] = index;
+    output->surfaces.size -= sizeof(*surfaces);
 }
 
 static int
@@ -114,6 +97,13 @@ wlf_output_done(struct wlf_output *output)
         return;
     }
 
+    mtx_lock(&output->global.context->output_lock);
+    struct wlf_surface **surface;
+    wl_array_for_each(surface, &output->surfaces) {
+        wlf_surface_handle_output_changed(*surface, output);
+    }
+    mtx_unlock(&output->global.context->output_lock);
+
     // TODO: handle atomic update
 }
 
@@ -242,7 +232,9 @@ wl_output_mode(
     output->pixel.width = width;
     output->pixel.height = height;
 
+    mtx_lock(&output->global.context->output_lock);
     output->refresh = refresh;
+    mtx_unlock(&output->global.context->output_lock);
 }
 
 static void
@@ -261,7 +253,10 @@ static void
 wl_output_scale(void *data, struct wl_output *, int32_t scale)
 {
     struct wlf_output *output = data;
+
+    mtx_lock(&output->global.context->output_lock);
     output->scale = scale;
+    mtx_unlock(&output->global.context->output_lock);
 }
 
 static void
@@ -342,6 +337,17 @@ wlf_output_bind(struct wlf_context *context, uint32_t name, uint32_t version)
         wlf_output_init_xdg(output);
     }
 
+    wl_array_init(&output->surfaces);
+
+    mtx_lock(&context->output_lock);
+    output->slot = WLF_OUTPUT_SLOT_NONE;
+    if (~context->output_slot_mask) {
+        output->slot = (uint32_t)__builtin_ctzll(~context->output_slot_mask);
+        context->output_slot_mask |= UINT64_C(1) << output->slot;
+        context->output_slots[output->slot] = output;
+    }
+    mtx_unlock(&context->output_lock);
+
     wl_list_insert(&context->output_list, &output->link);
     return output;
 }
@@ -351,10 +357,18 @@ wlf_output_destroy(struct wlf_output *output)
 {
     struct wlf_context *context = output->global.context;
 
-    struct wlf_surface *surface;
-    wl_list_for_each(surface, &context->surface_list, link) {
-        wlf_surface_handle_output_destroyed(surface, output);
+    mtx_lock(&context->output_lock);
+    struct wlf_surface **surface;
+    wl_array_for_each(surface, &output->surfaces) {
+        wlf_surface_handle_output_destroyed(*surface, output);
+    }
+    wl_array_release(&output->surfaces);
+
+    if (output->slot != WLF_OUTPUT_SLOT_NONE) {
+        context->output_slot_mask &= ~(UINT64_C(1) << output->slot);
+        context->output_slots[output->slot] = nullptr;
     }
+    mtx_unlock(&context->output_lock);
 
     if (output->xdg_output_v1) {
         zxdg_output_v1_destroy(output->xdg_output_v1);
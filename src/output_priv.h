@@ -7,6 +7,11 @@ struct wlf_output {
 
     struct wl_list link;
 
+    // Bit of this output in the surface output masks, NONE once the table is full.
+    uint32_t slot;
+    // Surfaces that entered this output, indexed by wlf_surface.output_index[slot].
+    struct wl_array surfaces;
+
     struct wl_output *wl_output;
     struct zxdg_output_v1 *xdg_output_v1;
     int done_count;
@@ -26,25 +31,17 @@ struct wlf_output {
     char *model;
 };
 
-struct wlf_output_ref {
-    struct wl_list link;
-    struct wlf_output *output;
-};
-
 int32_t
 wlf_output_get_scale(struct wlf_output *output);
 
 int32_t
-wlf_output_ref_list_get_max_scale(const struct wl_list *list);
-
-struct wlf_output_ref *
-wlf_output_ref_list_find(const struct wl_list *list, struct wlf_output *output);
+wlf_output_get_fractional_scale(struct wlf_output *output);
 
 bool
-wlf_output_ref_list_add(struct wl_list *list, struct wlf_output *output);
+wlf_output_add_surface(struct wlf_output *output, struct wlf_surface *surface);
 
-bool
-wlf_output_ref_list_remove(struct wl_list *list, struct wlf_output *output);
+void
+wlf_output_remove_surface(struct wlf_output *output, struct wlf_surface *surface);
 
 void
 wlf_output_init_xdg(struct wlf_output *output);
@@ -0,0 +1,851 @@
+#include <stdatomic.h>
+#include <string.h>
+#include <threads.h>
+
+#include <wayland-client-protocol.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define WLF_PIXEL_X86
+#include <immintrin.h>
+#endif
+
+// The kernels use AArch64 table lookups, 32-bit ARM stays on the scalar path.
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define WLF_PIXEL_NEON
+#include <arm_neon.h>
+#endif
+
+#include "wlf/pixel.h"
+
+// Rows are converted through this many ARGB8888 pixels at a time.
+constexpr int32_t WLF_PIXEL_CHUNK = 256;
+
+constexpr uint32_t WLF_PIXEL_ALPHA_MASK = 0xff00'0000;
+
+enum wlf_pixel_layout : uint32_t {
+    WLF_PIXEL_LAYOUT_8888 = 1,
+    WLF_PIXEL_LAYOUT_565 = 2,
+    WLF_PIXEL_LAYOUT_2101010 = 3,
+};
+
+struct wlf_pixel_format_desc {
+    uint32_t format;
+    enum wlf_pixel_layout layout;
+    uint32_t bpp;
+    bool alpha;
+    bool swap_rb;
+};
+
+static const struct wlf_pixel_format_desc wlf_pixel_formats[] = {
+    { WL_SHM_FORMAT_ARGB8888, WLF_PIXEL_LAYOUT_8888, 4, true, false },
+    { WL_SHM_FORMAT_XRGB8888, WLF_PIXEL_LAYOUT_8888, 4, false, false },
+    { WL_SHM_FORMAT_ABGR8888, WLF_PIXEL_LAYOUT_8888, 4, true, true },
+    { WL_SHM_FORMAT_XBGR8888, WLF_PIXEL_LAYOUT_8888, 4, false, true },
+    { WL_SHM_FORMAT_RGB565, WLF_PIXEL_LAYOUT_565, 2, false, false },
+    { WL_SHM_FORMAT_ARGB2101010, WLF_PIXEL_LAYOUT_2101010, 4, true, false },
+    { WL_SHM_FORMAT_XRGB2101010, WLF_PIXEL_LAYOUT_2101010, 4, false, false },
+    { WL_SHM_FORMAT_ABGR2101010, WLF_PIXEL_LAYOUT_2101010, 4, true, true },
+    { WL_SHM_FORMAT_XBGR2101010, WLF_PIXEL_LAYOUT_2101010, 4, false, true },
+};
+
+static const struct wlf_pixel_format_desc *
+wlf_pixel_format_find(uint32_t format)
+{
+    for (size_t i = 0; i < sizeof(wlf_pixel_formats) / sizeof(wlf_pixel_formats[0]); ++i) {
+        if (wlf_pixel_formats[i].format == format) {
+            return &wlf_pixel_formats[i];
+        }
+    }
+    return nullptr;
+}
+
+struct wlf_pixel_kernels {
+    enum wlf_pixel_isa isa;
+    void (*copy_or)(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask);
+    void (*swap_rb_or)(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask);
+    void (*premultiply)(uint32_t *data, int32_t n);
+    void (*fill32)(uint32_t *dst, uint32_t value, int32_t n);
+    void (*pack_565)(uint16_t *dst, const uint32_t *src, int32_t n);
+};
+
+// region Scalar
+
+static inline uint32_t
+wlf_div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t
+wlf_swap_rb(uint32_t p)
+{
+    return (p & 0xff00'ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+}
+
+static inline uint32_t
+wlf_premultiply_8888(uint32_t p)
+{
+    uint32_t a = p >> 24;
+    uint32_t c0 = wlf_div255((p & 0xff) * a);
+    uint32_t c1 = wlf_div255(((p >> 8) & 0xff) * a);
+    uint32_t c2 = wlf_div255(((p >> 16) & 0xff) * a);
+    return (p & WLF_PIXEL_ALPHA_MASK) | (c2 << 16) | (c1 << 8) | c0;
+}
+
+static inline uint16_t
+wlf_pack_565(uint32_t p)
+{
+    return (uint16_t)(((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f));
+}
+
+static void
+wlf_copy_or_scalar(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    for (int32_t i = 0; i < n; ++i) {
+        dst[i] = src[i] | mask;
+    }
+}
+
+static void
+wlf_swap_rb_or_scalar(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    for (int32_t i = 0; i < n; ++i) {
+        dst[i] = wlf_swap_rb(src[i]) | mask;
+    }
+}
+
+static void
+wlf_premultiply_scalar(uint32_t *data, int32_t n)
+{
+    for (int32_t i = 0; i < n; ++i) {
+        data[i] = wlf_premultiply_8888(data[i]);
+    }
+}
+
+static void
+wlf_fill32_scalar(uint32_t *dst, uint32_t value, int32_t n)
+{
+    for (int32_t i = 0; i < n; ++i) {
+        dst[i] = value;
+    }
+}
+
+static void
+wlf_pack_565_scalar(uint16_t *dst, const uint32_t *src, int32_t n)
+{
+    for (int32_t i = 0; i < n; ++i) {
+        dst[i] = wlf_pack_565(src[i]);
+    }
+}
+
+static const struct wlf_pixel_kernels wlf_pixel_kernels_scalar = {
+    .isa = WLF_PIXEL_ISA_SCALAR,
+    .copy_or = wlf_copy_or_scalar,
+    .swap_rb_or = wlf_swap_rb_or_scalar,
+    .premultiply = wlf_premultiply_scalar,
+    .fill32 = wlf_fill32_scalar,
+    .pack_565 = wlf_pack_565_scalar,
+};
+
+// endregion
+
+#ifdef WLF_PIXEL_X86
+
+// region SSE2
+
+[[gnu::target("sse2")]]
+static inline __m128i
+wlf_swap_rb_sse2(__m128i p)
+{
+    __m128i rb = _mm_and_si128(p, _mm_set1_epi32(0x00ff'00ff));
+    rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+    return _mm_or_si128(_mm_and_si128(p, _mm_set1_epi32((int32_t)0xff00'ff00)), rb);
+}
+
+[[gnu::target("sse2")]]
+static inline __m128i
+wlf_premultiply_half_sse2(__m128i c)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xff), 0xff);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+[[gnu::target("sse2")]]
+static void
+wlf_copy_or_sse2(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    __m128i m = _mm_set1_epi32((int32_t)mask);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(p, m));
+    }
+    wlf_copy_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+[[gnu::target("sse2")]]
+static void
+wlf_swap_rb_or_sse2(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    __m128i m = _mm_set1_epi32((int32_t)mask);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(wlf_swap_rb_sse2(p), m));
+    }
+    wlf_swap_rb_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+[[gnu::target("sse2")]]
+static void
+wlf_premultiply_sse2(uint32_t *data, int32_t n)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha = _mm_set1_epi32((int32_t)WLF_PIXEL_ALPHA_MASK);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i lo = wlf_premultiply_half_sse2(_mm_unpacklo_epi8(p, zero));
+        __m128i hi = wlf_premultiply_half_sse2(_mm_unpackhi_epi8(p, zero));
+        __m128i c = _mm_packus_epi16(lo, hi);
+        c = _mm_or_si128(_mm_andnot_si128(alpha, c), _mm_and_si128(p, alpha));
+        _mm_storeu_si128((__m128i *)(data + i), c);
+    }
+    wlf_premultiply_scalar(data + i, n - i);
+}
+
+[[gnu::target("sse2")]]
+static void
+wlf_fill32_sse2(uint32_t *dst, uint32_t value, int32_t n)
+{
+    __m128i v = _mm_set1_epi32((int32_t)value);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+    wlf_fill32_scalar(dst + i, value, n - i);
+}
+
+[[gnu::target("sse2")]]
+static inline __m128i
+wlf_pack_565_sse2(__m128i p)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xf800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07e0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001f));
+    __m128i v = _mm_or_si128(_mm_or_si128(r, g), b);
+
+    // Sign-extend so the saturating pack keeps all 16 bits.
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+[[gnu::target("sse2")]]
+static void
+wlf_pack_565_sse2_row(uint16_t *dst, const uint32_t *src, int32_t n)
+{
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = wlf_pack_565_sse2(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m128i b = wlf_pack_565_sse2(_mm_loadu_si128((const __m128i *)(src + i + 4)));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(a, b));
+    }
+    wlf_pack_565_scalar(dst + i, src + i, n - i);
+}
+
+static const struct wlf_pixel_kernels wlf_pixel_kernels_sse2 = {
+    .isa = WLF_PIXEL_ISA_SSE2,
+    .copy_or = wlf_copy_or_sse2,
+    .swap_rb_or = wlf_swap_rb_or_sse2,
+    .premultiply = wlf_premultiply_sse2,
+    .fill32 = wlf_fill32_sse2,
+    .pack_565 = wlf_pack_565_sse2_row,
+};
+
+// endregion
+
+// region AVX2
+
+[[gnu::target("avx2")]]
+static void
+wlf_copy_or_avx2(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    __m256i m = _mm256_set1_epi32((int32_t)mask);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(p, m));
+    }
+    wlf_copy_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+[[gnu::target("avx2")]]
+static void
+wlf_swap_rb_or_avx2(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    __m256i m = _mm256_set1_epi32((int32_t)mask);
+    __m256i shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+        p = _mm256_or_si256(_mm256_shuffle_epi8(p, shuffle), m);
+        _mm256_storeu_si256((__m256i *)(dst + i), p);
+    }
+    wlf_swap_rb_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+[[gnu::target("avx2")]]
+static inline __m256i
+wlf_premultiply_half_avx2(__m256i c)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, 0xff), 0xff);
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+[[gnu::target("avx2")]]
+static void
+wlf_premultiply_avx2(uint32_t *data, int32_t n)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i alpha = _mm256_set1_epi32((int32_t)WLF_PIXEL_ALPHA_MASK);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i lo = wlf_premultiply_half_avx2(_mm256_unpacklo_epi8(p, zero));
+        __m256i hi = wlf_premultiply_half_avx2(_mm256_unpackhi_epi8(p, zero));
+        __m256i c = _mm256_packus_epi16(lo, hi);
+        c = _mm256_or_si256(_mm256_andnot_si256(alpha, c), _mm256_and_si256(p, alpha));
+        _mm256_storeu_si256((__m256i *)(data + i), c);
+    }
+    wlf_premultiply_scalar(data + i, n - i);
+}
+
+[[gnu::target("avx2")]]
+static void
+wlf_fill32_avx2(uint32_t *dst, uint32_t value, int32_t n)
+{
+    __m256i v = _mm256_set1_epi32((int32_t)value);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    wlf_fill32_scalar(dst + i, value, n - i);
+}
+
+[[gnu::target("avx2")]]
+static inline __m256i
+wlf_pack_565_avx2(__m256i p)
+{
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xf800));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x07e0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x001f));
+    __m256i v = _mm256_or_si256(_mm256_or_si256(r, g), b);
+    return _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+}
+
+[[gnu::target("avx2")]]
+static void
+wlf_pack_565_avx2_row(uint16_t *dst, const uint32_t *src, int32_t n)
+{
+    int32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = wlf_pack_565_avx2(_mm256_loadu_si256((const __m256i *)(src + i)));
+        __m256i b = wlf_pack_565_avx2(_mm256_loadu_si256((const __m256i *)(src + i + 8)));
+
+        // The pack works per 128-bit lane; restore the pixel order afterwards.
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    wlf_pack_565_scalar(dst + i, src + i, n - i);
+}
+
+static const struct wlf_pixel_kernels wlf_pixel_kernels_avx2 = {
+    .isa = WLF_PIXEL_ISA_AVX2,
+    .copy_or = wlf_copy_or_avx2,
+    .swap_rb_or = wlf_swap_rb_or_avx2,
+    .premultiply = wlf_premultiply_avx2,
+    .fill32 = wlf_fill32_avx2,
+    .pack_565 = wlf_pack_565_avx2_row,
+};
+
+// endregion
+
+#endif
+
+#ifdef WLF_PIXEL_NEON
+
+// region NEON
+
+static inline uint8x8_t
+wlf_mul_div255_neon(uint8x8_t c, uint8x8_t a)
+{
+    uint16x8_t x = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+static void
+wlf_copy_or_neon(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    uint32x4_t m = vdupq_n_u32(mask);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_u32(dst + i, vorrq_u32(vld1q_u32(src + i), m));
+    }
+    wlf_copy_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+static void
+wlf_swap_rb_or_neon(uint32_t *dst, const uint32_t *src, int32_t n, uint32_t mask)
+{
+    uint8x16_t shuffle = { 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+    uint32x4_t m = vdupq_n_u32(mask);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint8x16_t p = vqtbl1q_u8(vreinterpretq_u8_u32(vld1q_u32(src + i)), shuffle);
+        vst1q_u32(dst + i, vorrq_u32(vreinterpretq_u32_u8(p), m));
+    }
+    wlf_swap_rb_or_scalar(dst + i, src + i, n - i, mask);
+}
+
+static void
+wlf_premultiply_neon(uint32_t *data, int32_t n)
+{
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(data + i));
+        p.val[0] = wlf_mul_div255_neon(p.val[0], p.val[3]);
+        p.val[1] = wlf_mul_div255_neon(p.val[1], p.val[3]);
+        p.val[2] = wlf_mul_div255_neon(p.val[2], p.val[3]);
+        vst4_u8((uint8_t *)(data + i), p);
+    }
+    wlf_premultiply_scalar(data + i, n - i);
+}
+
+static void
+wlf_fill32_neon(uint32_t *dst, uint32_t value, int32_t n)
+{
+    uint32x4_t v = vdupq_n_u32(value);
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_u32(dst + i, v);
+    }
+    wlf_fill32_scalar(dst + i, value, n - i);
+}
+
+static void
+wlf_pack_565_neon(uint16_t *dst, const uint32_t *src, int32_t n)
+{
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+        uint16x8_t v = vshll_n_u8(p.val[2], 8);
+        v = vsriq_n_u16(v, vshll_n_u8(p.val[1], 8), 5);
+        v = vsriq_n_u16(v, vshll_n_u8(p.val[0], 8), 11);
+        vst1q_u16(dst + i, v);
+    }
+    wlf_pack_565_scalar(dst + i, src + i, n - i);
+}
+
+static const struct wlf_pixel_kernels wlf_pixel_kernels_neon = {
+    .isa = WLF_PIXEL_ISA_NEON,
+    .copy_or = wlf_copy_or_neon,
+    .swap_rb_or = wlf_swap_rb_or_neon,
+    .premultiply = wlf_premultiply_neon,
+    .fill32 = wlf_fill32_neon,
+    .pack_565 = wlf_pack_565_neon,
+};
+
+// endregion
+
+#endif
+
+// region Dispatch
+
+static const struct wlf_pixel_kernels *
+wlf_pixel_kernels_for(enum wlf_pixel_isa isa)
+{
+    switch (isa) {
+        case WLF_PIXEL_ISA_SCALAR:
+            return &wlf_pixel_kernels_scalar;
+#ifdef WLF_PIXEL_X86
+        case WLF_PIXEL_ISA_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2") ? &wlf_pixel_kernels_sse2 : nullptr;
+        case WLF_PIXEL_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &wlf_pixel_kernels_avx2 : nullptr;
+#endif
+#ifdef WLF_PIXEL_NEON
+        case WLF_PIXEL_ISA_NEON:
+            return &wlf_pixel_kernels_neon;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+static _Atomic(const struct wlf_pixel_kernels *) wlf_pixel_active;
+static once_flag wlf_pixel_once = ONCE_FLAG_INIT;
+
+static void
+wlf_pixel_init(void)
+{
+    static const enum wlf_pixel_isa preferred[] = {
+        WLF_PIXEL_ISA_AVX2,
+        WLF_PIXEL_ISA_NEON,
+        WLF_PIXEL_ISA_SSE2,
+    };
+
+    const struct wlf_pixel_kernels *kernels = &wlf_pixel_kernels_scalar;
+    for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i) {
+        const struct wlf_pixel_kernels *k = wlf_pixel_kernels_for(preferred[i]);
+        if (k) {
+            kernels = k;
+            break;
+        }
+    }
+
+    atomic_store_explicit(&wlf_pixel_active, kernels, memory_order_relaxed);
+}
+
+static const struct wlf_pixel_kernels *
+wlf_pixel_get_kernels(void)
+{
+    call_once(&wlf_pixel_once, wlf_pixel_init);
+    return atomic_load_explicit(&wlf_pixel_active, memory_order_relaxed);
+}
+
+enum wlf_pixel_isa
+wlf_pixel_get_isa(void)
+{
+    return wlf_pixel_get_kernels()->isa;
+}
+
+enum wlf_result
+wlf_pixel_set_isa(enum wlf_pixel_isa isa)
+{
+    const struct wlf_pixel_kernels *kernels = wlf_pixel_kernels_for(isa);
+    if (!kernels) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    call_once(&wlf_pixel_once, wlf_pixel_init);
+    atomic_store_explicit(&wlf_pixel_active, kernels, memory_order_relaxed);
+    return WLF_SUCCESS;
+}
+
+const char *
+wlf_pixel_isa_get_name(enum wlf_pixel_isa isa)
+{
+    switch (isa) {
+        case WLF_PIXEL_ISA_SCALAR:
+            return "scalar";
+        case WLF_PIXEL_ISA_SSE2:
+            return "sse2";
+        case WLF_PIXEL_ISA_AVX2:
+            return "avx2";
+        case WLF_PIXEL_ISA_NEON:
+            return "neon";
+        default:
+            return nullptr;
+    }
+}
+
+// endregion
+
+// region Rows
+
+static inline uint32_t
+wlf_expand_10_to_8(uint32_t c)
+{
+    return (c >> 2) & 0xff;
+}
+
+static inline uint32_t
+wlf_expand_8_to_10(uint32_t c)
+{
+    return (c << 2) | (c >> 6);
+}
+
+// Unpacks a row of any supported format into ARGB8888.
+static void
+wlf_pixel_unpack_row(
+    const struct wlf_pixel_kernels *k,
+    const struct wlf_pixel_format_desc *desc,
+    uint32_t *dst,
+    const void *src,
+    int32_t n)
+{
+    uint32_t mask = desc->alpha ? 0 : WLF_PIXEL_ALPHA_MASK;
+
+    switch (desc->layout) {
+        case WLF_PIXEL_LAYOUT_8888:
+            if (desc->swap_rb) {
+                k->swap_rb_or(dst, src, n, mask);
+            } else {
+                k->copy_or(dst, src, n, mask);
+            }
+            break;
+        case WLF_PIXEL_LAYOUT_565: {
+            const uint16_t *s = src;
+            for (int32_t i = 0; i < n; ++i) {
+                uint32_t r = (s[i] >> 11) & 0x1f;
+                uint32_t g = (s[i] >> 5) & 0x3f;
+                uint32_t b = s[i] & 0x1f;
+                r = (r << 3) | (r >> 2);
+                g = (g << 2) | (g >> 4);
+                b = (b << 3) | (b >> 2);
+                dst[i] = WLF_PIXEL_ALPHA_MASK | (r << 16) | (g << 8) | b;
+            }
+            break;
+        }
+        case WLF_PIXEL_LAYOUT_2101010: {
+            const uint32_t *s = src;
+            for (int32_t i = 0; i < n; ++i) {
+                uint32_t a = (s[i] >> 30) * 0x55;
+                uint32_t c2 = wlf_expand_10_to_8(s[i] >> 20);
+                uint32_t c1 = wlf_expand_10_to_8(s[i] >> 10);
+                uint32_t c0 = wlf_expand_10_to_8(s[i]);
+                uint32_t p = (a << 24) | (c2 << 16) | (c1 << 8) | c0;
+                dst[i] = (desc->swap_rb ? wlf_swap_rb(p) : p) | mask;
+            }
+            break;
+        }
+    }
+}
+
+// Packs a row of ARGB8888 into any supported format.
+static void
+wlf_pixel_pack_row(
+    const struct wlf_pixel_kernels *k,
+    const struct wlf_pixel_format_desc *desc,
+    void *dst,
+    const uint32_t *src,
+    int32_t n)
+{
+    switch (desc->layout) {
+        case WLF_PIXEL_LAYOUT_8888:
+            if (desc->swap_rb) {
+                k->swap_rb_or(dst, src, n, 0);
+            } else {
+                memcpy(dst, src, (size_t)n * sizeof(uint32_t));
+            }
+            break;
+        case WLF_PIXEL_LAYOUT_565:
+            k->pack_565(dst, src, n);
+            break;
+        case WLF_PIXEL_LAYOUT_2101010: {
+            uint32_t *d = dst;
+            for (int32_t i = 0; i < n; ++i) {
+                uint32_t p = desc->swap_rb ? wlf_swap_rb(src[i]) : src[i];
+                uint32_t a = (p >> 30) & 0x3;
+                uint32_t c2 = wlf_expand_8_to_10((p >> 16) & 0xff);
+                uint32_t c1 = wlf_expand_8_to_10((p >> 8) & 0xff);
+                uint32_t c0 = wlf_expand_8_to_10(p & 0xff);
+                d[i] = (a << 30) | (c2 << 20) | (c1 << 10) | c0;
+            }
+            break;
+        }
+    }
+}
+
+static uint32_t
+wlf_premultiply_2101010(uint32_t p)
+{
+    uint32_t a = p >> 30;
+    uint32_t c2 = (((p >> 20) & 0x3ff) * a + 1) / 3;
+    uint32_t c1 = (((p >> 10) & 0x3ff) * a + 1) / 3;
+    uint32_t c0 = ((p & 0x3ff) * a + 1) / 3;
+    return (a << 30) | (c2 << 20) | (c1 << 10) | c0;
+}
+
+// endregion
+
+static inline void *
+wlf_pixel_at(const struct wlf_pixel_image *image, uint32_t bpp, int32_t x, int32_t y)
+{
+    return (char *)image->data + (ptrdiff_t)y * image->stride + (ptrdiff_t)x * bpp;
+}
+
+static bool
+wlf_rect_clip(struct wlf_rect *rect, struct wlf_extent extent)
+{
+    int32_t x0 = rect->offset.x < 0 ? 0 : rect->offset.x;
+    int32_t y0 = rect->offset.y < 0 ? 0 : rect->offset.y;
+    int64_t x1 = (int64_t)rect->offset.x + rect->extent.width;
+    int64_t y1 = (int64_t)rect->offset.y + rect->extent.height;
+    x1 = x1 > extent.width ? extent.width : x1;
+    y1 = y1 > extent.height ? extent.height : y1;
+
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+
+    *rect = (struct wlf_rect) {
+        .offset = { x0, y0 },
+        .extent = { (int32_t)(x1 - x0), (int32_t)(y1 - y0) },
+    };
+    return true;
+}
+
+bool
+wlf_pixel_format_supported(uint32_t format)
+{
+    return wlf_pixel_format_find(format) != nullptr;
+}
+
+// A null rect list covers the whole image; otherwise only the given
+// (typically damaged) rects are touched.
+enum wlf_result
+wlf_pixel_convert(
+    const struct wlf_pixel_image *dst,
+    const struct wlf_pixel_image *src,
+    const struct wlf_rect *rects,
+    uint32_t rect_count)
+{
+    const struct wlf_pixel_format_desc *dd = wlf_pixel_format_find(dst->format);
+    const struct wlf_pixel_format_desc *sd = wlf_pixel_format_find(src->format);
+    if (!dd || !sd) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    const struct wlf_pixel_kernels *k = wlf_pixel_get_kernels();
+
+    struct wlf_extent extent = {
+        dst->extent.width < src->extent.width ? dst->extent.width : src->extent.width,
+        dst->extent.height < src->extent.height ? dst->extent.height : src->extent.height,
+    };
+    struct wlf_rect full = { .extent = extent };
+    if (!rects) {
+        rects = &full;
+        rect_count = 1;
+    }
+
+    // Between 8888 formats a single swizzle pass is enough.
+    bool direct = dd->layout == WLF_PIXEL_LAYOUT_8888 && sd->layout == WLF_PIXEL_LAYOUT_8888;
+    uint32_t mask = !sd->alpha && dd->alpha ? WLF_PIXEL_ALPHA_MASK : 0;
+
+    uint32_t tmp[WLF_PIXEL_CHUNK];
+
+    for (uint32_t r = 0; r < rect_count; ++r) {
+        struct wlf_rect rect = rects[r];
+        if (!wlf_rect_clip(&rect, extent)) {
+            continue;
+        }
+
+        for (int32_t y = rect.offset.y; y < rect.offset.y + rect.extent.height; ++y) {
+            if (direct) {
+                uint32_t *d = wlf_pixel_at(dst, 4, rect.offset.x, y);
+                const uint32_t *s = wlf_pixel_at(src, 4, rect.offset.x, y);
+                if (dd->swap_rb != sd->swap_rb) {
+                    k->swap_rb_or(d, s, rect.extent.width, mask);
+                } else if (mask) {
+                    k->copy_or(d, s, rect.extent.width, mask);
+                } else {
+                    memmove(d, s, (size_t)rect.extent.width * sizeof(uint32_t));
+                }
+                continue;
+            }
+
+            for (int32_t x = rect.offset.x; x < rect.offset.x + rect.extent.width; x += WLF_PIXEL_CHUNK) {
+                int32_t n = rect.offset.x + rect.extent.width - x;
+                n = n > WLF_PIXEL_CHUNK ? WLF_PIXEL_CHUNK : n;
+                wlf_pixel_unpack_row(k, sd, tmp, wlf_pixel_at(src, sd->bpp, x, y), n);
+                wlf_pixel_pack_row(k, dd, wlf_pixel_at(dst, dd->bpp, x, y), tmp, n);
+            }
+        }
+    }
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_pixel_premultiply(
+    const struct wlf_pixel_image *image,
+    const struct wlf_rect *rects,
+    uint32_t rect_count)
+{
+    const struct wlf_pixel_format_desc *desc = wlf_pixel_format_find(image->format);
+    if (!desc) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (!desc->alpha) {
+        return WLF_SKIPPED;
+    }
+
+    const struct wlf_pixel_kernels *k = wlf_pixel_get_kernels();
+
+    struct wlf_rect full = { .extent = image->extent };
+    if (!rects) {
+        rects = &full;
+        rect_count = 1;
+    }
+
+    for (uint32_t r = 0; r < rect_count; ++r) {
+        struct wlf_rect rect = rects[r];
+        if (!wlf_rect_clip(&rect, image->extent)) {
+            continue;
+        }
+
+        for (int32_t y = rect.offset.y; y < rect.offset.y + rect.extent.height; ++y) {
+            uint32_t *row = wlf_pixel_at(image, 4, rect.offset.x, y);
+            if (desc->layout == WLF_PIXEL_LAYOUT_8888) {
+                k->premultiply(row, rect.extent.width);
+                continue;
+            }
+            for (int32_t i = 0; i < rect.extent.width; ++i) {
+                row[i] = wlf_premultiply_2101010(row[i]);
+            }
+        }
+    }
+    return WLF_SUCCESS;
+}
+
+// The colour is given as ARGB8888 and converted to the image format once.
+enum wlf_result
+wlf_pixel_fill(
+    const struct wlf_pixel_image *image,
+    uint32_t argb,
+    const struct wlf_rect *rects,
+    uint32_t rect_count)
+{
+    const struct wlf_pixel_format_desc *desc = wlf_pixel_format_find(image->format);
+    if (!desc) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    const struct wlf_pixel_kernels *k = wlf_pixel_get_kernels();
+
+    uint32_t value = 0;
+    wlf_pixel_pack_row(k, desc, &value, &argb, 1);
+
+    struct wlf_rect full = { .extent = image->extent };
+    if (!rects) {
+        rects = &full;
+        rect_count = 1;
+    }
+
+    for (uint32_t r = 0; r < rect_count; ++r) {
+        struct wlf_rect rect = rects[r];
+        if (!wlf_rect_clip(&rect, image->extent)) {
+            continue;
+        }
+
+        for (int32_t y = rect.offset.y; y < rect.offset.y + rect.extent.height; ++y) {
+            void *row = wlf_pixel_at(image, desc->bpp, rect.offset.x, y);
+            if (desc->bpp == 4) {
+                k->fill32(row, value, rect.extent.width);
+                continue;
+            }
+            uint16_t *row16 = row;
+            for (int32_t i = 0; i < rect.extent.width; ++i) {
+                row16[i] = (uint16_t)value;
+            }
+        }
+    }
+    return WLF_SUCCESS;
+}
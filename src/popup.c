@@ -100,17 +100,13 @@ wlf_popup_configure(struct wlf_popup *p, uint32_t serial)
     p->s.transform = p->current.transform;
 
     if (resized || !p->configured) {
-        struct wlf_extent se = wlf_surface_get_extent(&p->s);
         struct wlf_extent be = wlf_surface_get_buffer_extent(&p->s);
 
         if (p->s.wl_egl_window) {
             wl_egl_window_resize(p->s.wl_egl_window, be.width, be.height, 0, 0);
         }
 
-        if (p->s.wp_fractional_scale_v1) {
-            assert(p->s.wp_viewport);
-            wp_viewport_set_destination(p->s.wp_viewport, se.width, se.height);
-        }
+        wlf_surface_update_viewport(&p->s);
 
         p->listener.configure(p->s.user_data, be);
     }
@@ -189,13 +185,7 @@ static void
 xdg_surface_configure(void *data, struct xdg_surface *xdg_surface, uint32_t serial)
 {
     struct wlf_popup *popup = data;
-
-    if (popup->events != WLF_POPUP_EVENT_NONE || !popup->configured) {
-        wlf_popup_configure(popup, serial);
-    }
-
-    xdg_surface_ack_configure(popup->xdg_surface, serial);
-    popup->configured = true;
+    wlf_surface_queue_configure(&popup->s, serial);
 }
 
 static const struct xdg_surface_listener xdg_surface_listener = {
@@ -206,6 +196,26 @@ static const struct xdg_surface_listener xdg_surface_listener = {
 
 // region Surface
 
+static void
+wlf_popup_handle_configure(struct wlf_surface *surface, uint32_t serial)
+{
+    struct wlf_popup *popup = wl_container_of(surface, popup, s);
+
+    if (popup->events != WLF_POPUP_EVENT_NONE || !popup->configured) {
+        wlf_popup_configure(popup, serial);
+    }
+
+    wlf_surface_ack(&popup->s, serial);
+    popup->configured = true;
+}
+
+static void
+wlf_popup_send_ack(struct wlf_surface *surface, uint32_t serial)
+{
+    struct wlf_popup *popup = wl_container_of(surface, popup, s);
+    xdg_surface_ack_configure(popup->xdg_surface, serial);
+}
+
 static void
 wlf_popup_configure_scale(struct wlf_surface *surface, int32_t scale)
 {
@@ -296,7 +306,11 @@ wlf_popup_init(
         return WLF_ERROR_INVALID_ARGUMENT;
     }
 
-    enum wlf_result res = wlf_surface_init(context, WLF_SURFACE_TYPE_POPUP, &popup->s);
+    enum wlf_result res = wlf_surface_init(
+        context,
+        WLF_SURFACE_TYPE_POPUP,
+        info->flags & WLF_POPUP_FLAGS_EVENT_QUEUE,
+        &popup->s);
     if (res < WLF_SUCCESS) {
         return res;
     }
@@ -304,9 +318,19 @@ wlf_popup_init(
     popup->listener = *listener;
     popup->s.configure_scale = wlf_popup_configure_scale,
     popup->s.configure_transform = wlf_popup_configure_transform,
+    popup->s.configure = wlf_popup_handle_configure;
+    popup->s.send_ack = wlf_popup_send_ack;
+    popup->s.defer_ack = info->flags & WLF_POPUP_FLAGS_DEFERRED_ACK;
+    popup->s.fifo = info->flags & WLF_POPUP_FLAGS_FIFO;
     popup->s.user_data = info->user_data;
 
-    popup->xdg_surface = xdg_wm_base_get_xdg_surface(context->xdg_wm_base, popup->s.wl_surface);
+    struct xdg_wm_base *wm_base = wlf_surface_wrap_proxy(&popup->s, context->xdg_wm_base);
+    if (!wm_base) {
+        wlf_surface_fini(&popup->s);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    popup->xdg_surface = xdg_wm_base_get_xdg_surface(wm_base, popup->s.wl_surface);
+    wlf_surface_unwrap_proxy(&popup->s, wm_base);
     xdg_surface_add_listener(popup->xdg_surface, &xdg_surface_listener, popup);
 
     struct xdg_positioner *pos = xdg_wm_base_create_positioner(context->xdg_wm_base);
@@ -337,6 +361,12 @@ wlf_popup_create(
     const struct wlf_popup_listener *listener,
     struct wlf_popup **_popup)
 {
+    if (!context->ready) {
+        return WLF_ERROR_UNINITIALIZED;
+    }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
     if (!context->xdg_wm_base) {
         return WLF_ERROR_UNSUPPORTED;
     }
@@ -0,0 +1,426 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <wayland-client-protocol.h>
+
+#include "common_priv.h"
+#include "context_priv.h"
+#include "surface_priv.h"
+#include "shm_priv.h"
+#include "log_priv.h"
+
+constexpr size_t WLF_SHM_PAGE_SIZE = 4096;
+
+struct wlf_shm_format_desc {
+    uint32_t format;
+    uint32_t bpp;
+};
+
+static const struct wlf_shm_format_desc wlf_shm_formats[] = {
+    { WL_SHM_FORMAT_ARGB8888, 4 },
+    { WL_SHM_FORMAT_XRGB8888, 4 },
+    { WL_SHM_FORMAT_ABGR8888, 4 },
+    { WL_SHM_FORMAT_XBGR8888, 4 },
+    { WL_SHM_FORMAT_RGBA8888, 4 },
+    { WL_SHM_FORMAT_RGBX8888, 4 },
+    { WL_SHM_FORMAT_BGRA8888, 4 },
+    { WL_SHM_FORMAT_BGRX8888, 4 },
+    { WL_SHM_FORMAT_ARGB2101010, 4 },
+    { WL_SHM_FORMAT_XRGB2101010, 4 },
+    { WL_SHM_FORMAT_ABGR2101010, 4 },
+    { WL_SHM_FORMAT_XBGR2101010, 4 },
+    { WL_SHM_FORMAT_RGB888, 3 },
+    { WL_SHM_FORMAT_BGR888, 3 },
+    { WL_SHM_FORMAT_RGB565, 2 },
+    { WL_SHM_FORMAT_BGR565, 2 },
+    { WL_SHM_FORMAT_ARGB4444, 2 },
+    { WL_SHM_FORMAT_XRGB4444, 2 },
+    { WL_SHM_FORMAT_ARGB1555, 2 },
+    { WL_SHM_FORMAT_XRGB1555, 2 },
+    { WL_SHM_FORMAT_GR88, 2 },
+    { WL_SHM_FORMAT_R8, 1 },
+    { WL_SHM_FORMAT_ABGR16161616F, 8 },
+    { WL_SHM_FORMAT_XBGR16161616F, 8 },
+    { WL_SHM_FORMAT_ABGR16161616, 8 },
+    { WL_SHM_FORMAT_XBGR16161616, 8 },
+};
+
+constexpr int32_t WLF_SHM_FORMAT_COUNT = sizeof(wlf_shm_formats) / sizeof(wlf_shm_formats[0]);
+
+static_assert(WLF_SHM_FORMAT_COUNT <= 64, "shm format mask is 64 bits wide");
+
+int32_t
+wlf_shm_format_index(uint32_t format)
+{
+    // The two formats every compositor supports map to their own index.
+    if (format <= WL_SHM_FORMAT_XRGB8888) {
+        return (int32_t)format;
+    }
+
+    for (int32_t i = 2; i < WLF_SHM_FORMAT_COUNT; ++i) {
+        if (wlf_shm_formats[i].format == format) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool
+wlf_context_has_shm_format(struct wlf_context *context, uint32_t format)
+{
+    int32_t index = wlf_shm_format_index(format);
+    if (index >= 0) {
+        return context->shm_format_mask & (UINT64_C(1) << index);
+    }
+
+    uint32_t *it;
+    wl_array_for_each(it, &context->format_array) {
+        if (*it == format) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// region WL Buffer
+
+static void
+wl_buffer_release(void *data, struct wl_buffer *)
+{
+    struct wlf_shm_buffer *buffer = data;
+    atomic_store_explicit(&buffer->busy, false, memory_order_release);
+}
+
+static const struct wl_buffer_listener wl_buffer_listener = {
+    .release = wl_buffer_release,
+};
+
+// endregion
+
+static size_t
+wlf_shm_capacity(size_t size)
+{
+    // Headroom keeps interactive resizes from growing the pool every frame.
+    size += size / 4;
+    return (size + WLF_SHM_PAGE_SIZE - 1) & ~(WLF_SHM_PAGE_SIZE - 1);
+}
+
+static enum wlf_result
+wlf_shm_pool_grow(struct wlf_shm_pool *pool, size_t size)
+{
+    if (size <= pool->size) {
+        return WLF_SUCCESS;
+    }
+
+    if (size > INT32_MAX) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    int ret;
+    do {
+        ret = ftruncate(pool->fd, (off_t)size);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        wlf_error("Failed to grow shm pool to %zu bytes.\n", size);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    void *data = mremap(pool->data, pool->size, size, MREMAP_MAYMOVE);
+    if (data == MAP_FAILED) {
+        wlf_error("Failed to remap shm pool.\n");
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    pool->data = data;
+    pool->size = size;
+    wl_shm_pool_resize(pool->wl_shm_pool, (int32_t)size);
+    return WLF_SUCCESS;
+}
+
+static void
+wlf_shm_buffer_reset(struct wlf_shm_buffer *buffer)
+{
+    if (buffer->wl_buffer) {
+        wl_buffer_destroy(buffer->wl_buffer);
+        buffer->wl_buffer = nullptr;
+    }
+    atomic_store_explicit(&buffer->busy, false, memory_order_relaxed);
+}
+
+static void
+wlf_shm_pool_layout(struct wlf_shm_pool *pool, size_t capacity)
+{
+    for (uint32_t i = 0; i < pool->buffer_count; ++i) {
+        struct wlf_shm_buffer *buffer = &pool->buffers[i];
+        wlf_shm_buffer_reset(buffer);
+        buffer->offset = i * capacity;
+        buffer->capacity = capacity;
+    }
+}
+
+static enum wlf_result
+wlf_shm_pool_set_extent(struct wlf_shm_pool *pool, struct wlf_extent extent)
+{
+    if (extent.width <= 0 || extent.height <= 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    int64_t stride = (int64_t)extent.width * pool->bpp;
+    if (stride * extent.height > INT32_MAX) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    pool->extent = extent;
+    pool->stride = (int32_t)stride;
+    return WLF_SUCCESS;
+}
+
+// A pool is used from one thread only, buffer releases are the one thing that
+// may arrive from the thread dispatching the context.
+enum wlf_result
+wlf_shm_pool_create(
+    struct wlf_context *context,
+    const struct wlf_shm_pool_info *info,
+    struct wlf_shm_pool **pool)
+{
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+    if (!context->wl_shm) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (info->buffer_count == 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    int32_t index = wlf_shm_format_index(info->format);
+    if (index < 0 || !wlf_context_has_shm_format(context, info->format)) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    size_t n = sizeof(struct wlf_shm_pool) + info->buffer_count * sizeof(struct wlf_shm_buffer);
+    struct wlf_shm_pool *p = calloc(1, n);
+    if (!p) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    p->context = context;
+    p->format = info->format;
+    p->bpp = wlf_shm_formats[index].bpp;
+    p->buffer_count = info->buffer_count;
+    p->fd = -1;
+    p->data = MAP_FAILED;
+
+    for (uint32_t i = 0; i < p->buffer_count; ++i) {
+        p->buffers[i].pool = p;
+    }
+
+    enum wlf_result r = wlf_shm_pool_set_extent(p, info->extent);
+    if (r < WLF_SUCCESS) {
+        goto fail;
+    }
+
+    size_t capacity = wlf_shm_capacity((size_t)p->stride * p->extent.height);
+    p->size = capacity * p->buffer_count;
+    if (p->size > INT32_MAX) {
+        r = WLF_ERROR_INVALID_ARGUMENT;
+        goto fail;
+    }
+
+    r = WLF_ERROR_OUT_OF_MEMORY;
+
+    p->fd = memfd_create("wleaf-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (p->fd < 0) {
+        wlf_error("Failed to create memfd for shm pool.\n");
+        goto fail;
+    }
+
+    if (ftruncate(p->fd, (off_t)p->size) < 0) {
+        wlf_error("Failed to size shm pool to %zu bytes.\n", p->size);
+        goto fail;
+    }
+
+    // The compositor maps the same file; it must never shrink under it.
+    fcntl(p->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL);
+
+    p->data = mmap(nullptr, p->size, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (p->data == MAP_FAILED) {
+        wlf_error("Failed to map shm pool.\n");
+        goto fail;
+    }
+
+    p->wl_shm_pool = wl_shm_create_pool(context->wl_shm, p->fd, (int32_t)p->size);
+    if (!p->wl_shm_pool) {
+        goto fail;
+    }
+
+    wlf_shm_pool_layout(p, capacity);
+
+    *pool = p;
+    return WLF_SUCCESS;
+
+fail:
+    if (p->data != MAP_FAILED) {
+        munmap(p->data, p->size);
+    }
+    if (p->fd >= 0) {
+        close(p->fd);
+    }
+    free(p);
+    return r;
+}
+
+void
+wlf_shm_pool_destroy(struct wlf_shm_pool *pool)
+{
+    for (uint32_t i = 0; i < pool->buffer_count; ++i) {
+        wlf_shm_buffer_reset(&pool->buffers[i]);
+    }
+
+    wl_shm_pool_destroy(pool->wl_shm_pool);
+    munmap(pool->data, pool->size);
+    close(pool->fd);
+    free(pool);
+}
+
+// Buffers held by the compositor or the caller keep their memory; they are
+// recreated with the new extent, and relocated if too small, on acquire.
+enum wlf_result
+wlf_shm_pool_resize(struct wlf_shm_pool *pool, struct wlf_extent extent)
+{
+    if (wlf_extent_equal(pool->extent, extent)) {
+        return WLF_SKIPPED;
+    }
+
+    enum wlf_result r = wlf_shm_pool_set_extent(pool, extent);
+    if (r < WLF_SUCCESS) {
+        return r;
+    }
+
+    size_t size = (size_t)pool->stride * pool->extent.height;
+    bool idle = true;
+    bool fits = true;
+    for (uint32_t i = 0; i < pool->buffer_count; ++i) {
+        struct wlf_shm_buffer *buffer = &pool->buffers[i];
+        idle = idle && !buffer->acquired &&
+               !atomic_load_explicit(&buffer->busy, memory_order_acquire);
+        fits = fits && buffer->capacity >= size;
+    }
+
+    if (!idle || fits) {
+        return WLF_SUCCESS;
+    }
+
+    // Every buffer is idle, so the pool can be compacted in place.
+    size_t capacity = wlf_shm_capacity(size);
+    r = wlf_shm_pool_grow(pool, capacity * pool->buffer_count);
+    if (r < WLF_SUCCESS) {
+        return r;
+    }
+
+    wlf_shm_pool_layout(pool, capacity);
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_shm_pool_acquire(struct wlf_shm_pool *pool, struct wlf_shm_buffer **buffer)
+{
+    struct wlf_shm_buffer *b = nullptr;
+    for (uint32_t i = 0; i < pool->buffer_count; ++i) {
+        struct wlf_shm_buffer *candidate = &pool->buffers[i];
+        if (!candidate->acquired &&
+            !atomic_load_explicit(&candidate->busy, memory_order_acquire))
+        {
+            b = candidate;
+            break;
+        }
+    }
+
+    if (!b) {
+        return WLF_PENDING;
+    }
+
+    size_t size = (size_t)pool->stride * pool->extent.height;
+    if (b->capacity < size) {
+        wlf_shm_buffer_reset(b);
+
+        size_t offset = pool->size;
+        size_t capacity = wlf_shm_capacity(size);
+        enum wlf_result r = wlf_shm_pool_grow(pool, offset + capacity);
+        if (r < WLF_SUCCESS) {
+            return r;
+        }
+
+        b->offset = offset;
+        b->capacity = capacity;
+    }
+
+    if (b->wl_buffer && !wlf_extent_equal(b->extent, pool->extent)) {
+        wlf_shm_buffer_reset(b);
+    }
+
+    if (!b->wl_buffer) {
+        b->wl_buffer = wl_shm_pool_create_buffer(
+            pool->wl_shm_pool,
+            (int32_t)b->offset,
+            pool->extent.width,
+            pool->extent.height,
+            pool->stride,
+            pool->format);
+        if (!b->wl_buffer) {
+            return WLF_ERROR_OUT_OF_MEMORY;
+        }
+        wl_buffer_add_listener(b->wl_buffer, &wl_buffer_listener, b);
+        b->extent = pool->extent;
+        b->stride = pool->stride;
+    }
+
+    b->acquired = true;
+    *buffer = b;
+    return WLF_SUCCESS;
+}
+
+void
+wlf_shm_buffer_discard(struct wlf_shm_buffer *buffer)
+{
+    buffer->acquired = false;
+}
+
+// The pointer stays valid until the pool grows on a later acquire or resize.
+void *
+wlf_shm_buffer_get_data(struct wlf_shm_buffer *buffer)
+{
+    return (char *)buffer->pool->data + buffer->offset;
+}
+
+int32_t
+wlf_shm_buffer_get_stride(struct wlf_shm_buffer *buffer)
+{
+    return buffer->stride;
+}
+
+struct wlf_extent
+wlf_shm_buffer_get_extent(struct wlf_shm_buffer *buffer)
+{
+    return buffer->extent;
+}
+
+enum wlf_result
+wlf_surface_attach_shm_buffer(struct wlf_surface *surface, struct wlf_shm_buffer *buffer)
+{
+    if (!buffer->acquired) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    wl_surface_attach(surface->wl_surface, buffer->wl_buffer, 0, 0);
+    surface->damage.attached = true;
+
+    buffer->acquired = false;
+    atomic_store_explicit(&buffer->busy, true, memory_order_relaxed);
+    return WLF_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "wlf/shm.h"
+
+struct wlf_shm_buffer {
+    struct wlf_shm_pool *pool;
+    struct wl_buffer *wl_buffer;
+
+    size_t offset;
+    size_t capacity;
+    struct wlf_extent extent;
+    int32_t stride;
+
+    // Held by the compositor until wl_buffer.release. The release is
+    // dispatched on the default queue, which may run on another thread than
+    // the one using the pool.
+    atomic_bool busy;
+    bool acquired;
+};
+
+struct wlf_shm_pool {
+    struct wlf_context *context;
+    struct wl_shm_pool *wl_shm_pool;
+
+    int fd;
+    void *data;
+    size_t size;
+
+    struct wlf_extent extent;
+    int32_t stride;
+    uint32_t format;
+    uint32_t bpp;
+
+    uint32_t buffer_count;
+    struct wlf_shm_buffer buffers[];
+};
+
+int32_t
+wlf_shm_format_index(uint32_t format);
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include <wayland-client-protocol.h>
+#include <wayland-egl-core.h>
+#include <viewporter-client-protocol.h>
+
+#include "common_priv.h"
+#include "context_priv.h"
+#include "subsurface_priv.h"
+
+static void
+wlf_subsurface_update_buffer(struct wlf_subsurface *sub, bool rescaled, bool transformed)
+{
+    uint32_t version = wl_surface_get_version(sub->s.wl_surface);
+    if (rescaled && !sub->s.wp_fractional_scale_v1) {
+        assert(version >= WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION);
+        wl_surface_set_buffer_scale(sub->s.wl_surface, sub->s.scale);
+    }
+
+    if (transformed) {
+        assert(version >= WL_SURFACE_SET_BUFFER_TRANSFORM_SINCE_VERSION);
+        wl_surface_set_buffer_transform(sub->s.wl_surface, sub->s.transform);
+    }
+
+    if (sub->s.wl_egl_window) {
+        struct wlf_extent be = wlf_surface_get_buffer_extent(&sub->s);
+        wl_egl_window_resize(sub->s.wl_egl_window, be.width, be.height, 0, 0);
+    }
+
+    wlf_surface_update_viewport(&sub->s);
+}
+
+static void
+wlf_subsurface_emit_configure(struct wlf_subsurface *sub)
+{
+    if (sub->listener.configure) {
+        sub->listener.configure(sub->s.user_data, wlf_surface_get_buffer_extent(&sub->s));
+    }
+}
+
+// region Surface
+
+// Subsurfaces have no configure handshake, so scale and transform changes
+// reported by the compositor are applied right away.
+static void
+wlf_subsurface_configure_scale(struct wlf_surface *surface, int32_t scale)
+{
+    struct wlf_subsurface *sub = wl_container_of(surface, sub, s);
+    if (sub->s.scale == scale) {
+        return;
+    }
+
+    sub->s.scale = scale;
+    wlf_subsurface_update_buffer(sub, true, false);
+    wlf_subsurface_emit_configure(sub);
+}
+
+static void
+wlf_subsurface_configure_transform(struct wlf_surface *surface, enum wlf_transform transform)
+{
+    struct wlf_subsurface *sub = wl_container_of(surface, sub, s);
+    if (sub->s.transform == transform) {
+        return;
+    }
+
+    sub->s.transform = transform;
+    wlf_subsurface_update_buffer(sub, false, true);
+    wlf_subsurface_emit_configure(sub);
+}
+
+// endregion
+
+static void
+wlf_subsurface_init_state(struct wlf_subsurface *sub, const struct wlf_subsurface_info *info)
+{
+    // Until the compositor reports otherwise the subsurface follows its parent.
+    struct wlf_surface *parent = info->parent;
+    if (parent->scale > 0) {
+        sub->s.scale = parent->scale;
+    } else {
+        sub->s.scale = sub->s.wp_fractional_scale_v1 ? 120 : 1;
+    }
+    sub->s.transform = parent->transform;
+    sub->s.extent = info->extent;
+
+    // A viewport lets buffers of any size be shown at the logical extent.
+    sub->s.viewport_sized = sub->s.wp_viewport != nullptr;
+
+    wlf_subsurface_update_buffer(
+        sub,
+        sub->s.scale != 1,
+        sub->s.transform != WLF_TRANSFORM_NONE);
+
+    if (info->flags & WLF_SUBSURFACE_FLAGS_DESYNC) {
+        wl_subsurface_set_desync(sub->wl_subsurface);
+        sub->sync = false;
+    }
+
+    wlf_subsurface_set_position(sub, info->position);
+}
+
+static enum wlf_result
+wlf_subsurface_init(
+    struct wlf_context *context,
+    const struct wlf_subsurface_info *info,
+    const struct wlf_subsurface_listener *listener,
+    struct wlf_subsurface *sub)
+{
+    enum wlf_result res = wlf_surface_init(
+        context,
+        WLF_SURFACE_TYPE_SUBSURFACE,
+        info->flags & WLF_SUBSURFACE_FLAGS_EVENT_QUEUE,
+        &sub->s);
+    if (res < WLF_SUCCESS) {
+        return res;
+    }
+
+    sub->listener = *listener;
+    sub->s.configure_scale = wlf_subsurface_configure_scale;
+    sub->s.configure_transform = wlf_subsurface_configure_transform;
+    sub->s.user_data = info->user_data;
+    sub->s.fifo = info->flags & WLF_SUBSURFACE_FLAGS_FIFO;
+    sub->parent = info->parent;
+    sub->sync = true;
+
+    sub->wl_subsurface = wl_subcompositor_get_subsurface(
+        context->wl_subcompositor,
+        sub->s.wl_surface,
+        info->parent->wl_surface);
+    if (!sub->wl_subsurface) {
+        wlf_surface_fini(&sub->s);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    wlf_subsurface_init_state(sub, info);
+    return WLF_SUCCESS;
+}
+
+static void
+wlf_subsurface_fini(struct wlf_subsurface *sub)
+{
+    wl_subsurface_destroy(sub->wl_subsurface);
+    wlf_surface_fini(&sub->s);
+}
+
+enum wlf_result
+wlf_subsurface_create(
+    struct wlf_context *context,
+    const struct wlf_subsurface_info *info,
+    const struct wlf_subsurface_listener *listener,
+    struct wlf_subsurface **_subsurface)
+{
+    if (!context->ready) {
+        return WLF_ERROR_UNINITIALIZED;
+    }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
+    if (!info->parent || info->extent.width <= 0 || info->extent.height <= 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct wlf_subsurface *sub = calloc(1, sizeof(struct wlf_subsurface));
+    if (!sub) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    enum wlf_result res = wlf_subsurface_init(context, info, listener, sub);
+    if (res < WLF_SUCCESS) {
+        free(sub);
+        return res;
+    }
+
+    *_subsurface = sub;
+    return WLF_SUCCESS;
+}
+
+void
+wlf_subsurface_destroy(struct wlf_subsurface *subsurface)
+{
+    wlf_subsurface_fini(subsurface);
+    free(subsurface);
+}
+
+struct wlf_surface *
+wlf_subsurface_get_surface(struct wlf_subsurface *subsurface)
+{
+    return &subsurface->s;
+}
+
+struct wlf_subsurface *
+wlf_subsurface_from_surface(struct wlf_surface *surface)
+{
+    struct wlf_subsurface *sub = nullptr;
+    if (surface->type == WLF_SURFACE_TYPE_SUBSURFACE) {
+        sub = wl_container_of(surface, sub, s);
+    }
+    return sub;
+}
+
+struct wlf_extent
+wlf_subsurface_get_buffer_extent(struct wlf_subsurface *subsurface)
+{
+    return wlf_surface_get_buffer_extent(&subsurface->s);
+}
+
+// Like the stacking order, the position is applied with the next parent commit.
+void
+wlf_subsurface_set_position(struct wlf_subsurface *subsurface, struct wlf_offset position)
+{
+    wl_subsurface_set_position(subsurface->wl_subsurface, position.x, position.y);
+    subsurface->position = position;
+}
+
+static bool
+wlf_subsurface_is_sibling(struct wlf_subsurface *subsurface, struct wlf_surface *sibling)
+{
+    if (sibling == subsurface->parent) {
+        return true;
+    }
+
+    struct wlf_subsurface *other = wlf_subsurface_from_surface(sibling);
+    return other && other != subsurface && other->parent == subsurface->parent;
+}
+
+enum wlf_result
+wlf_subsurface_place_above(struct wlf_subsurface *subsurface, struct wlf_surface *sibling)
+{
+    if (!wlf_subsurface_is_sibling(subsurface, sibling)) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+    wl_subsurface_place_above(subsurface->wl_subsurface, sibling->wl_surface);
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_subsurface_place_below(struct wlf_subsurface *subsurface, struct wlf_surface *sibling)
+{
+    if (!wlf_subsurface_is_sibling(subsurface, sibling)) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+    wl_subsurface_place_below(subsurface->wl_subsurface, sibling->wl_surface);
+    return WLF_SUCCESS;
+}
+
+// A desynchronized subsurface presents on its own commits, without waiting
+// for the parent, which keeps e.g. video frames off the UI commit path.
+void
+wlf_subsurface_set_sync(struct wlf_subsurface *subsurface, bool sync)
+{
+    if (subsurface->sync == sync) {
+        return;
+    }
+
+    if (sync) {
+        wl_subsurface_set_sync(subsurface->wl_subsurface);
+    } else {
+        wl_subsurface_set_desync(subsurface->wl_subsurface);
+    }
+    subsurface->sync = sync;
+}
+
+enum wlf_result
+wlf_subsurface_set_extent(struct wlf_subsurface *subsurface, struct wlf_extent extent)
+{
+    if (extent.width <= 0 || extent.height <= 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (wlf_extent_equal(subsurface->s.extent, extent)) {
+        return WLF_SKIPPED;
+    }
+
+    subsurface->s.extent = extent;
+    wlf_subsurface_update_buffer(subsurface, false, false);
+    wlf_subsurface_emit_configure(subsurface);
+    return WLF_SUCCESS;
+}
+
+// The source rect crops the buffer in buffer-local coordinates after the
+// buffer scale and transform are applied; a null rect shows the whole buffer.
+enum wlf_result
+wlf_subsurface_set_source(struct wlf_subsurface *subsurface, const struct wlf_rect *rect)
+{
+    struct wp_viewport *viewport = subsurface->s.wp_viewport;
+    if (!viewport) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (!rect) {
+        wl_fixed_t unset = wl_fixed_from_int(-1);
+        wp_viewport_set_source(viewport, unset, unset, unset, unset);
+        return WLF_SUCCESS;
+    }
+
+    if (rect->offset.x < 0 || rect->offset.y < 0 || rect->extent.width <= 0 || rect->extent.height <= 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    wp_viewport_set_source(
+        viewport,
+        wl_fixed_from_int(rect->offset.x),
+        wl_fixed_from_int(rect->offset.y),
+        wl_fixed_from_int(rect->extent.width),
+        wl_fixed_from_int(rect->extent.height));
+    return WLF_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "wlf/subsurface.h"
+#include "surface_priv.h"
+
+struct wlf_subsurface {
+    struct wlf_surface s;
+    struct wlf_subsurface_listener listener;
+
+    struct wl_subsurface *wl_subsurface;
+    struct wlf_surface *parent;
+
+    struct wlf_offset position;
+    bool sync;
+};
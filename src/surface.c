@@ -1,18 +1,32 @@
+#include <assert.h>
 #include <malloc.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <wayland-client-protocol.h>
 #include <wayland-egl-core.h>
 #include <viewporter-client-protocol.h>
+#include <presentation-time-client-protocol.h>
 #include <content-type-v1-client-protocol.h>
 #include <fractional-scale-v1-client-protocol.h>
 #include <idle-inhibit-unstable-v1-client-protocol.h>
 #include <alpha-modifier-v1-client-protocol.h>
+#include <single-pixel-buffer-v1-client-protocol.h>
+#include <tearing-control-v1-client-protocol.h>
+#include <fifo-v1-client-protocol.h>
+#include <commit-timing-v1-client-protocol.h>
 
 #include "common_priv.h"
 #include "context_priv.h"
 #include "input_priv.h"
 #include "output_priv.h"
 #include "surface_priv.h"
+#include "loop_priv.h"
+#include "dmabuf_priv.h"
+
+// Time reserved for the compositor to latch the buffer before vblank.
+constexpr int64_t WLF_FRAME_DEADLINE_MARGIN = 2'000'000;
 
 struct wlf_extent
 wlf_surface_get_extent(struct wlf_surface *surface)
@@ -23,33 +37,212 @@ wlf_surface_get_extent(struct wlf_surface *surface)
 struct wlf_extent
 wlf_surface_get_buffer_extent(struct wlf_surface *surface)
 {
-    struct wlf_extent extent = wlf_surface_get_extent(surface);
-    if (wlf_transform_is_vertical(surface->transform)) {
+    return wlf_surface_compute_buffer_extent(
+        surface,
+        wlf_surface_get_extent(surface),
+        surface->scale,
+        surface->transform);
+}
+
+// Buffer extent the surface would have at the given extent, scale and
+// transform.
+struct wlf_extent
+wlf_surface_compute_buffer_extent(
+    struct wlf_surface *surface,
+    struct wlf_extent extent,
+    int32_t scale,
+    enum wlf_transform transform)
+{
+    if (wlf_transform_is_vertical(transform)) {
         int32_t tmp = extent.width;
         extent.width = extent.height;
         extent.height = tmp;
     }
-    extent.width *= surface->scale;
-    extent.height *= surface->scale;
+    extent.width *= scale;
+    extent.height *= scale;
     if (surface->wp_fractional_scale_v1) {
         extent.width = wlf_div_round(extent.width, 120);
         extent.height = wlf_div_round(extent.height, 120);
     }
+    if (surface->render_scale > 0) {
+        extent.width = wlf_div_round(extent.width * (int32_t)surface->render_scale, 100);
+        extent.height = wlf_div_round(extent.height * (int32_t)surface->render_scale, 100);
+        extent.width = extent.width > 0 ? extent.width : 1;
+        extent.height = extent.height > 0 ? extent.height : 1;
+    }
     return extent;
 }
 
+// Factor from surface-local to buffer coordinates.
+static double
+wlf_surface_get_buffer_factor(struct wlf_surface *surface)
+{
+    double scale = surface->scale;
+    if (surface->wp_fractional_scale_v1) {
+        scale /= 120.0;
+    }
+    if (surface->render_scale > 0) {
+        scale *= surface->render_scale / 100.0;
+    }
+    return scale;
+}
+
+// Only the serial is recorded here, the role state accumulated by the
+// configure sequence is applied by wlf_surface_flush_configure().
+void
+wlf_surface_queue_configure(struct wlf_surface *surface, uint32_t serial)
+{
+    wlf_surface_schedule_flush(surface);
+    surface->configure_queued = true;
+    surface->configure_serial = serial;
+}
+
+// Surfaces with their own queue are flushed by wlf_surface_dispatch() after
+// every dispatch instead.
+void
+wlf_surface_schedule_flush(struct wlf_surface *surface)
+{
+    if (!surface->wl_event_queue && wl_list_empty(&surface->configure_link)) {
+        wl_list_insert(surface->context->configure_list.prev, &surface->configure_link);
+    }
+}
+
+void
+wlf_surface_flush_configure(struct wlf_surface *surface)
+{
+    wlf_surface_sync_output_scale(surface);
+
+    if (surface->configure_queued) {
+        surface->configure_queued = false;
+        surface->configure(surface, surface->configure_serial);
+    }
+}
+
+// Acking a newer serial implicitly acks all earlier ones, so a deferred
+// ack only needs to remember the latest.
+void
+wlf_surface_ack(struct wlf_surface *surface, uint32_t serial)
+{
+    if (surface->defer_ack) {
+        surface->ack_serial = serial;
+        surface->ack_pending = true;
+    } else {
+        surface->send_ack(surface, serial);
+    }
+}
+
+void
+wlf_surface_update_viewport(struct wlf_surface *surface)
+{
+    struct wlf_extent se = surface->viewport_extent;
+    if (se.width == 0) {
+        if (!surface->wp_fractional_scale_v1 && !surface->viewport_sized) {
+            return;
+        }
+        se = wlf_surface_get_extent(surface);
+    }
+
+    assert(surface->wp_viewport);
+    wp_viewport_set_destination(surface->wp_viewport, se.width, se.height);
+}
+
+// Shows the attached buffer at the given extent regardless of the surface
+// extent; a zero extent goes back to the regular destination.
+void
+wlf_surface_stretch_viewport(struct wlf_surface *surface, struct wlf_extent extent)
+{
+    bool stretched = surface->viewport_extent.width > 0;
+    surface->viewport_extent = extent;
+
+    if (stretched && extent.width == 0 &&
+        !surface->wp_fractional_scale_v1 && !surface->viewport_sized)
+    {
+        wp_viewport_set_destination(surface->wp_viewport, -1, -1);
+        return;
+    }
+
+    wlf_surface_update_viewport(surface);
+}
+
+// Output membership is shared with the main thread, which handles output
+// hotplug, so it is only touched with the context output lock held. The
+// buffer scale is applied by the thread dispatching the surface.
+
+static int32_t
+wlf_surface_compute_max_scale(struct wlf_surface *surface)
+{
+    int32_t max_scale = 1;
+
+    for (uint64_t mask = surface->output_mask; mask; mask &= mask - 1) {
+        uint32_t slot = (uint32_t)__builtin_ctzll(mask);
+        int32_t scale = wlf_output_get_scale(surface->context->output_slots[slot]);
+        if (scale > max_scale) {
+            max_scale = scale;
+        }
+    }
+
+    return max_scale;
+}
+
+static struct wlf_output *
+wlf_surface_find_earliest_output(struct wlf_surface *surface)
+{
+    struct wlf_output *earliest = nullptr;
+    uint32_t entered = 0;
+
+    for (uint64_t mask = surface->output_mask; mask; mask &= mask - 1) {
+        uint32_t slot = (uint32_t)__builtin_ctzll(mask);
+        if (!earliest || surface->output_entered[slot] < entered) {
+            earliest = surface->context->output_slots[slot];
+            entered = surface->output_entered[slot];
+        }
+    }
+
+    return earliest;
+}
+
+// Clients cannot see where a surface lies on its outputs, so the earliest
+// entered one that it is still on stands in for the largest overlap.
 static void
-wlf_surface_update_output(struct wlf_surface *surface, struct wlf_output *output, bool added)
+wlf_surface_set_output(struct wlf_surface *surface, struct wlf_output *output, bool entered)
 {
-    uint32_t version = wl_surface_get_version(surface->wl_surface);
-    struct wl_list *list = &surface->output_list;
+    uint64_t bit = UINT64_C(1) << output->slot;
+    int32_t scale = wlf_output_get_scale(output);
+
+    if (entered) {
+        surface->output_mask |= bit;
+        surface->output_entered[output->slot] = surface->output_enter_count++;
+        if (!surface->primary_output) {
+            surface->primary_output = output;
+        }
+        if (scale > surface->max_scale) {
+            surface->max_scale = scale;
+        }
+    } else {
+        surface->output_mask &= ~bit;
+        if (surface->primary_output == output) {
+            surface->primary_output = wlf_surface_find_earliest_output(surface);
+        }
+        if (scale >= surface->max_scale) {
+            surface->max_scale = wlf_surface_compute_max_scale(surface);
+        }
+    }
+}
+
+void
+wlf_surface_sync_output_scale(struct wlf_surface *surface)
+{
+    mtx_lock(&surface->context->output_lock);
+    int32_t max_scale = surface->max_scale;
+    mtx_unlock(&surface->context->output_lock);
 
-    bool updated = added
-                 ? wlf_output_ref_list_add(list, output)
-                 : wlf_output_ref_list_remove(list, output);
+    if (surface->output_scale == max_scale) {
+        return;
+    }
+    surface->output_scale = max_scale;
 
-    if (!updated ||
-        version < WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION ||
+    uint32_t version = wl_surface_get_version(surface->wl_surface);
+    if (version < WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION ||
 #ifdef WL_SURFACE_PREFERRED_BUFFER_SCALE_SINCE_VERSION
         version >= WL_SURFACE_PREFERRED_BUFFER_SCALE_SINCE_VERSION ||
 #endif
@@ -58,8 +251,42 @@ wlf_surface_update_output(struct wlf_surface *surface, struct wlf_output *output
         return;
     }
 
-    int32_t scale = wlf_output_ref_list_get_max_scale(list);
-    surface->configure_scale(surface, scale);
+    surface->configure_scale(surface, max_scale);
+}
+
+static void
+wlf_surface_update_output(struct wlf_surface *surface, struct wlf_output *output, bool added)
+{
+    mtx_t *lock = &surface->context->output_lock;
+    mtx_lock(lock);
+
+    bool member = output->slot != WLF_OUTPUT_SLOT_NONE &&
+                  (surface->output_mask & (UINT64_C(1) << output->slot));
+    bool updated = false;
+    if (output->slot != WLF_OUTPUT_SLOT_NONE && member != added) {
+        if (added) {
+            updated = wlf_output_add_surface(output, surface);
+        } else {
+            wlf_output_remove_surface(output, surface);
+            updated = true;
+        }
+    }
+    if (updated) {
+        wlf_surface_set_output(surface, output, added);
+    }
+
+    mtx_unlock(lock);
+
+    if (updated) {
+        wlf_surface_sync_output_scale(surface);
+    }
+}
+
+void
+wlf_surface_handle_output_changed(struct wlf_surface *s, struct wlf_output *)
+{
+    s->max_scale = wlf_surface_compute_max_scale(s);
+    wlf_surface_schedule_flush(s);
 }
 
 void
@@ -67,10 +294,432 @@ wlf_surface_handle_output_destroyed(struct wlf_surface *s, struct wlf_output *o)
 {
     // Some compositors like KWin send a wl_surface.leave event before destroying
     // the wl_output object. Others like Sway do not, so the surface scale needs to be
-    // updated when the wl_output object is destroyed.
-    wlf_surface_update_output(s, o, false);
+    // updated when the wl_output object is destroyed. The output drops its own
+    // surface array afterwards.
+    wlf_surface_set_output(s, o, false);
+    wlf_surface_schedule_flush(s);
+}
+
+static void
+wlf_surface_emit_frame(struct wlf_surface *surface, uint32_t time)
+{
+    surface->frame_emit_time = wlf_get_time_ns();
+    if (surface->listener.frame) {
+        surface->listener.frame(surface->user_data, time);
+    }
+}
+
+void
+wlf_surface_set_suspended(struct wlf_surface *surface, bool suspended)
+{
+    surface->suspended = suspended;
+
+    if (!suspended && surface->frame_deferred) {
+        surface->frame_deferred = false;
+        wlf_surface_emit_frame(surface, (uint32_t)(wlf_get_time_ns() / 1'000'000));
+    }
+}
+
+// region Damage
+
+static void
+wlf_surface_sync_damage(struct wlf_surface *surface)
+{
+    struct wlf_damage *damage = &surface->damage;
+    struct wlf_extent extent = wlf_surface_get_buffer_extent(surface);
+
+    // Buffer contents are invalid after a resize or transform change.
+    if (!wlf_extent_equal(damage->extent, extent) || damage->transform != surface->transform) {
+        wlf_damage_reset(damage, extent, surface->transform);
+    }
+}
+
+static int32_t
+wlf_floor_i32(double v)
+{
+    int32_t i = (int32_t)v;
+    return i - (v < i);
+}
+
+static int32_t
+wlf_ceil_i32(double v)
+{
+    int32_t i = (int32_t)v;
+    return i + (v > i);
+}
+
+static struct wlf_rect
+wlf_surface_rect_to_buffer(struct wlf_surface *surface, struct wlf_rect rect)
+{
+    struct wlf_extent extent = wlf_surface_get_extent(surface);
+    enum wlf_transform rev = wlf_transform_inverse(surface->transform);
+
+    struct wlf_point p0 = { rect.offset.x, rect.offset.y };
+    struct wlf_point p1 = {
+        (double)rect.offset.x + rect.extent.width,
+        (double)rect.offset.y + rect.extent.height,
+    };
+
+    p0 = wlf_point_transform(p0, extent, rev);
+    p1 = wlf_point_transform(p1, extent, rev);
+
+    double scale = wlf_surface_get_buffer_factor(surface);
+
+    int32_t x0 = wlf_floor_i32((p0.x < p1.x ? p0.x : p1.x) * scale);
+    int32_t y0 = wlf_floor_i32((p0.y < p1.y ? p0.y : p1.y) * scale);
+    int32_t x1 = wlf_ceil_i32((p0.x > p1.x ? p0.x : p1.x) * scale);
+    int32_t y1 = wlf_ceil_i32((p0.y > p1.y ? p0.y : p1.y) * scale);
+
+    struct wlf_extent be = surface->damage.extent;
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > be.width ? be.width : x1;
+    y1 = y1 > be.height ? be.height : y1;
+
+    return (struct wlf_rect) {
+        .offset = { x0, y0 },
+        .extent = { x1 - x0, y1 - y0 },
+    };
+}
+
+// Moves the pending damage into the buffer age history. A new buffer without
+// any reported damage is taken to be damaged as a whole.
+void
+wlf_surface_take_damage(struct wlf_surface *surface, struct wlf_region *region)
+{
+    wlf_surface_sync_damage(surface);
+
+    struct wlf_damage *damage = &surface->damage;
+    if (damage->pending.count == 0) {
+        wlf_region_add(&damage->pending, (struct wlf_rect) { .extent = damage->extent });
+    }
+
+    *region = damage->pending;
+    wlf_damage_commit(damage);
+}
+
+// endregion
+
+// region Tearing Control
+
+static enum wlf_result
+wlf_surface_apply_presentation_hint(struct wlf_surface *surface, enum wlf_presentation_hint hint)
+{
+    struct wlf_context *context = surface->context;
+    if (!context->wp_tearing_control_manager_v1) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (!surface->wp_tearing_control_v1) {
+        if (hint == WLF_PRESENTATION_HINT_VSYNC) {
+            return WLF_SKIPPED;
+        }
+        surface->wp_tearing_control_v1 = wp_tearing_control_manager_v1_get_tearing_control(
+            context->wp_tearing_control_manager_v1,
+            surface->wl_surface);
+        if (!surface->wp_tearing_control_v1) {
+            return WLF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (surface->presentation_hint == hint) {
+        return WLF_SKIPPED;
+    }
+
+    wp_tearing_control_v1_set_presentation_hint(surface->wp_tearing_control_v1, hint);
+    surface->presentation_hint = hint;
+    return WLF_SUCCESS;
+}
+
+static void
+wlf_surface_update_auto_tearing(struct wlf_surface *surface)
+{
+    if (!surface->auto_tearing) {
+        return;
+    }
+
+    bool async = surface->fullscreen && surface->content_type == WLF_CONTENT_TYPE_GAME;
+    wlf_surface_apply_presentation_hint(
+        surface,
+        async ? WLF_PRESENTATION_HINT_ASYNC : WLF_PRESENTATION_HINT_VSYNC);
+}
+
+void
+wlf_surface_set_fullscreen(struct wlf_surface *surface, bool fullscreen)
+{
+    surface->fullscreen = fullscreen;
+    wlf_surface_update_auto_tearing(surface);
+}
+
+// endregion
+
+// region Paced Presentation
+
+static struct wp_fifo_v1 *
+wlf_surface_get_fifo(struct wlf_surface *surface)
+{
+    if (!surface->wp_fifo_v1) {
+        surface->wp_fifo_v1 = wp_fifo_manager_v1_get_fifo(
+            surface->context->wp_fifo_manager_v1,
+            surface->wl_surface);
+    }
+    return surface->wp_fifo_v1;
+}
+
+static struct wp_commit_timer_v1 *
+wlf_surface_get_commit_timer(struct wlf_surface *surface)
+{
+    if (!surface->wp_commit_timer_v1) {
+        surface->wp_commit_timer_v1 = wp_commit_timing_manager_v1_get_timer(
+            surface->context->wp_commit_timing_manager_v1,
+            surface->wl_surface);
+    }
+    return surface->wp_commit_timer_v1;
+}
+
+// endregion
+
+// region Frame Scheduling
+
+uint64_t
+wlf_surface_get_primary_output(struct wlf_surface *surface)
+{
+    mtx_lock(&surface->context->output_lock);
+    uint64_t id = surface->primary_output ? surface->primary_output->global.id : 0;
+    mtx_unlock(&surface->context->output_lock);
+    return id;
+}
+
+int64_t
+wlf_surface_get_refresh(struct wlf_surface *surface)
+{
+    if (surface->presentation.refresh > 0) {
+        return surface->presentation.refresh;
+    }
+
+    mtx_lock(&surface->context->output_lock);
+    int32_t refresh = surface->primary_output ? surface->primary_output->refresh : 0;
+    mtx_unlock(&surface->context->output_lock);
+
+    if (refresh > 0) {
+        return 1'000'000'000'000 / refresh;
+    }
+    return 0;
+}
+
+static int64_t
+wlf_surface_predict_vblank(struct wlf_surface *surface, int64_t now, int64_t refresh)
+{
+    // Without presentation feedback on the timer clock, assume the frame
+    // callback was sent right after the previous vblank.
+    int64_t base = now;
+    const struct wlf_presentation_history *history = &surface->presentation;
+    if (history->last_time != 0 && surface->context->presentation_clock == CLOCK_MONOTONIC) {
+        base = history->last_time;
+    }
+    return base + ((now - base) / refresh + 1) * refresh;
+}
+
+static bool
+wlf_surface_schedule_frame(struct wlf_surface *surface, uint32_t time)
+{
+    int64_t refresh = wlf_surface_get_refresh(surface);
+    if (refresh <= 0 || !surface->frame_timer) {
+        return false;
+    }
+
+    int64_t now = wlf_get_time_ns();
+    int64_t vblank = wlf_surface_predict_vblank(surface, now, refresh);
+    int64_t wake = vblank - surface->render_cost - WLF_FRAME_DEADLINE_MARGIN;
+    if (wake <= now) {
+        return false;
+    }
+
+    if (wlf_source_arm_timer(surface->frame_timer, wake - now, 0) < WLF_SUCCESS) {
+        return false;
+    }
+    surface->frame_time = time;
+    surface->frame_scheduled = true;
+    return true;
+}
+
+static void
+wlf_surface_frame_timer(void *data)
+{
+    struct wlf_surface *surface = data;
+
+    if (!surface->frame_scheduled) {
+        return;
+    }
+    surface->frame_scheduled = false;
+
+    if (surface->suspended) {
+        surface->frame_deferred = true;
+        return;
+    }
+    wlf_surface_emit_frame(surface, surface->frame_time);
+}
+
+// Render cost is the time from a tick to the request for the next frame.
+static void
+wlf_surface_update_render_cost(struct wlf_surface *surface)
+{
+    if (surface->frame_emit_time == 0) {
+        return;
+    }
+
+    int64_t cost = wlf_get_time_ns() - surface->frame_emit_time;
+    surface->frame_emit_time = 0;
+
+    if (surface->render_cost == 0) {
+        surface->render_cost = cost;
+    } else {
+        surface->render_cost += (cost - surface->render_cost) / 8;
+    }
+}
+
+// endregion
+
+// region WL Callback
+
+static void
+wl_frame_done(void *data, struct wl_callback *wl_callback, uint32_t time)
+{
+    struct wlf_surface *surface = data;
+
+    wl_callback_destroy(wl_callback);
+    surface->frame_callback = nullptr;
+
+    if (surface->suspended) {
+        surface->frame_deferred = true;
+        return;
+    }
+
+    if (surface->frame_mode == WLF_FRAME_MODE_DEADLINE &&
+        wlf_surface_schedule_frame(surface, time))
+    {
+        return;
+    }
+
+    wlf_surface_emit_frame(surface, time);
+}
+
+static const struct wl_callback_listener wl_frame_listener = {
+    .done = wl_frame_done,
+};
+
+// endregion
+
+// region WP Presentation Feedback
+
+static void
+wlf_feedback_destroy(struct wlf_feedback *feedback)
+{
+    wl_list_remove(&feedback->link);
+    wp_presentation_feedback_destroy(feedback->wp_feedback);
+    free(feedback);
 }
 
+static void
+wlf_presentation_history_add(
+    struct wlf_presentation_history *history,
+    const struct wlf_presentation_feedback *fb)
+{
+    history->presented++;
+    history->refresh = fb->refresh;
+
+    // Only vblanks that passed while the frame was already committed count as
+    // missed, so idle periods between frames are not. A quarter cycle is
+    // left for timestamp jitter and the compositor latching the buffer.
+    if (fb->refresh > 0 && fb->commit_time > 0) {
+        int64_t start = fb->commit_time > history->last_time ? fb->commit_time : history->last_time;
+        int64_t cycles = (fb->present_time - start + fb->refresh * 3 / 4) / fb->refresh;
+        if (cycles > 1) {
+            history->missed += (uint64_t)(cycles - 1);
+        }
+    }
+    history->last_time = fb->present_time;
+
+    // Frames committed without wleaf have no commit time.
+    if (fb->commit_time == 0) {
+        return;
+    }
+    history->latency[history->latency_next] = fb->present_time - fb->commit_time;
+    history->latency_next = (history->latency_next + 1) % WLF_PRESENTATION_HISTORY;
+    if (history->latency_count < WLF_PRESENTATION_HISTORY) {
+        history->latency_count++;
+    }
+}
+
+static void
+wp_presentation_feedback_sync_output(
+    void *data,
+    struct wp_presentation_feedback *,
+    struct wl_output *)
+{
+}
+
+static void
+wp_presentation_feedback_presented(
+    void *data,
+    struct wp_presentation_feedback *,
+    uint32_t tv_sec_hi,
+    uint32_t tv_sec_lo,
+    uint32_t tv_nsec,
+    uint32_t refresh,
+    uint32_t seq_hi,
+    uint32_t seq_lo,
+    uint32_t flags)
+{
+    struct wlf_feedback *feedback = data;
+    struct wlf_surface *surface = feedback->surface;
+
+    struct wlf_presentation_feedback fb = {
+        .commit_time = feedback->commit_time,
+        .present_time = wlf_tv_to_ns(tv_sec_hi, tv_sec_lo, tv_nsec),
+        .refresh = refresh,
+        .msc = ((uint64_t)seq_hi << 32) | seq_lo,
+        .flags = flags,
+    };
+
+    wlf_feedback_destroy(feedback);
+    wlf_presentation_history_add(&surface->presentation, &fb);
+
+    if (surface->listener.presented) {
+        surface->listener.presented(surface->user_data, &fb);
+    }
+}
+
+static void
+wp_presentation_feedback_discarded(void *data, struct wp_presentation_feedback *)
+{
+    struct wlf_feedback *feedback = data;
+    struct wlf_surface *surface = feedback->surface;
+
+    wlf_feedback_destroy(feedback);
+    surface->presentation.discarded++;
+
+    if (surface->listener.discarded) {
+        surface->listener.discarded(surface->user_data);
+    }
+}
+
+static const struct wp_presentation_feedback_listener wp_presentation_feedback_listener = {
+    .sync_output = wp_presentation_feedback_sync_output,
+    .presented   = wp_presentation_feedback_presented,
+    .discarded   = wp_presentation_feedback_discarded,
+};
+
+static int
+wlf_compare_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// endregion
+
 // region WP Fractional Scale
 
 static void
@@ -144,29 +793,76 @@ static const struct wl_surface_listener wl_surface_listener = {
 
 // endregion
 
+// Objects whose events must land on the surface queue have to be created
+// through a wrapper of their factory. Objects created from those objects
+// inherit the queue on their own.
+void *
+wlf_surface_wrap_proxy(struct wlf_surface *surface, void *proxy)
+{
+    if (!proxy || !surface->wl_event_queue) {
+        return proxy;
+    }
+
+    void *wrapper = wl_proxy_create_wrapper(proxy);
+    if (wrapper) {
+        wl_proxy_set_queue(wrapper, surface->wl_event_queue);
+    }
+    return wrapper;
+}
+
+void
+wlf_surface_unwrap_proxy(struct wlf_surface *surface, void *wrapper)
+{
+    if (wrapper && surface->wl_event_queue) {
+        wl_proxy_wrapper_destroy(wrapper);
+    }
+}
+
 enum wlf_result
 wlf_surface_init(
     struct wlf_context *context,
     enum wlf_surface_type type,
+    bool event_queue,
     struct wlf_surface *surface)
 {
     surface->context = context;
     surface->type = type;
 
-    wl_list_init(&surface->output_list);
+    surface->max_scale = 1;
+    surface->output_scale = 1;
+    wl_list_init(&surface->feedback_list);
+    wl_list_init(&surface->configure_link);
+
+    if (event_queue) {
+        surface->wl_event_queue = wl_display_create_queue(context->wl_display);
+        if (!surface->wl_event_queue) {
+            return WLF_ERROR_OUT_OF_MEMORY;
+        }
+    }
 
-    surface->wl_surface = wl_compositor_create_surface(context->wl_compositor);
+    struct wl_compositor *compositor = wlf_surface_wrap_proxy(surface, context->wl_compositor);
+    if (!compositor) {
+        goto err_queue;
+    }
+    surface->wl_surface = wl_compositor_create_surface(compositor);
+    wlf_surface_unwrap_proxy(surface, compositor);
+    if (!surface->wl_surface) {
+        goto err_queue;
+    }
     wl_surface_add_listener(surface->wl_surface, &wl_surface_listener, surface);
 
-    if (context->wp_viewporter) {
-        surface->wp_viewport = wp_viewporter_get_viewport(
-            context->wp_viewporter,
-            surface->wl_surface);
+    struct wp_viewporter *viewporter = wlf_surface_wrap_proxy(surface, context->wp_viewporter);
+    if (viewporter) {
+        surface->wp_viewport = wp_viewporter_get_viewport(viewporter, surface->wl_surface);
+        wlf_surface_unwrap_proxy(surface, viewporter);
 
-        if (context->wp_fractional_scale_manager_v1) {
+        struct wp_fractional_scale_manager_v1 *fractional_scale_manager
+            = wlf_surface_wrap_proxy(surface, context->wp_fractional_scale_manager_v1);
+        if (fractional_scale_manager) {
             surface->wp_fractional_scale_v1 = wp_fractional_scale_manager_v1_get_fractional_scale(
-                context->wp_fractional_scale_manager_v1,
+                fractional_scale_manager,
                 surface->wl_surface);
+            wlf_surface_unwrap_proxy(surface, fractional_scale_manager);
             wp_fractional_scale_v1_add_listener(
                 surface->wp_fractional_scale_v1,
                 &wp_fractional_scale_listener,
@@ -188,12 +884,19 @@ wlf_surface_init(
 
     wl_list_insert(&context->surface_list, &surface->link);
     return WLF_SUCCESS;
+
+err_queue:
+    if (surface->wl_event_queue) {
+        wl_event_queue_destroy(surface->wl_event_queue);
+    }
+    return WLF_ERROR_OUT_OF_MEMORY;
 }
 
 void
 wlf_surface_fini(struct wlf_surface *surface)
 {
     wl_list_remove(&surface->link);
+    wl_list_remove(&surface->configure_link);
 
     struct wlf_context *context = surface->context;
 
@@ -202,10 +905,40 @@ wlf_surface_fini(struct wlf_surface *surface)
         wlf_seat_handle_surface_destroyed(seat, surface);
     }
 
-    struct wlf_output_ref *ref, *ref_tmp;
-    wl_list_for_each_safe(ref, ref_tmp, &surface->output_list, link) {
-        wl_list_remove(&ref->link);
-        free(ref);
+    mtx_lock(&context->output_lock);
+    for (uint64_t mask = surface->output_mask; mask; mask &= mask - 1) {
+        uint32_t slot = (uint32_t)__builtin_ctzll(mask);
+        wlf_output_remove_surface(context->output_slots[slot], surface);
+    }
+    mtx_unlock(&context->output_lock);
+
+    if (surface->frame_timer) {
+        wlf_source_remove(surface->frame_timer);
+    }
+
+    if (surface->frame_callback) {
+        wl_callback_destroy(surface->frame_callback);
+    }
+
+    struct wlf_feedback *feedback, *feedback_tmp;
+    wl_list_for_each_safe(feedback, feedback_tmp, &surface->feedback_list, link) {
+        wlf_feedback_destroy(feedback);
+    }
+
+    if (surface->dmabuf_feedback) {
+        wlf_dmabuf_state_destroy(surface->dmabuf_feedback);
+    }
+
+    if (surface->wp_tearing_control_v1) {
+        wp_tearing_control_v1_destroy(surface->wp_tearing_control_v1);
+    }
+
+    if (surface->wp_commit_timer_v1) {
+        wp_commit_timer_v1_destroy(surface->wp_commit_timer_v1);
+    }
+
+    if (surface->wp_fifo_v1) {
+        wp_fifo_v1_destroy(surface->wp_fifo_v1);
     }
 
     if (surface->wp_alpha_modifier_surface_v1) {
@@ -233,6 +966,10 @@ wlf_surface_fini(struct wlf_surface *surface)
     }
 
     wl_surface_destroy(surface->wl_surface);
+
+    if (surface->wl_event_queue) {
+        wl_event_queue_destroy(surface->wl_event_queue);
+    }
 }
 
 struct wl_egl_window *
@@ -271,6 +1008,302 @@ wlf_surface_get_user_data(struct wlf_surface *surface)
     return surface->user_data;
 }
 
+void
+wlf_surface_set_listener(struct wlf_surface *surface, const struct wlf_surface_listener *listener)
+{
+    surface->listener = *listener;
+}
+
+static void
+wl_solid_buffer_release(void *, struct wl_buffer *wl_buffer)
+{
+    wl_buffer_destroy(wl_buffer);
+}
+
+static const struct wl_buffer_listener wl_solid_buffer_listener = {
+    .release = wl_solid_buffer_release,
+};
+
+static uint32_t
+wlf_color_to_u32(float c)
+{
+    c = c < 0.0f ? 0.0f : c > 1.0f ? 1.0f : c;
+    return (uint32_t)((double)c * UINT32_MAX + 0.5);
+}
+
+// Attaches a premultiplied single-pixel buffer stretched over the surface.
+// No memory is allocated for the pixels on either side.
+enum wlf_result
+wlf_surface_attach_solid_color(struct wlf_surface *surface, struct wlf_color color)
+{
+    struct wp_single_pixel_buffer_manager_v1 *manager
+        = surface->context->wp_single_pixel_buffer_manager_v1;
+    if (!manager || !surface->wp_viewport) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    struct wlf_extent se = wlf_surface_get_extent(surface);
+    if (se.width <= 0 || se.height <= 0) {
+        return WLF_ERROR_UNINITIALIZED;
+    }
+
+    float a = color.a < 0.0f ? 0.0f : color.a > 1.0f ? 1.0f : color.a;
+    struct wl_buffer *buffer = wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(
+        manager,
+        wlf_color_to_u32(color.r * a),
+        wlf_color_to_u32(color.g * a),
+        wlf_color_to_u32(color.b * a),
+        wlf_color_to_u32(a));
+    if (!buffer) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    // Kept alive until the compositor is done with it.
+    wl_buffer_add_listener(buffer, &wl_solid_buffer_listener, nullptr);
+
+    surface->viewport_sized = true;
+    wlf_surface_update_viewport(surface);
+
+    wl_surface_attach(surface->wl_surface, buffer, 0, 0);
+    wl_surface_damage_buffer(surface->wl_surface, 0, 0, 1, 1);
+    return WLF_SUCCESS;
+}
+
+// Damage is only submitted with a newly attached buffer; otherwise it stays
+// pending for the next one.
+void
+wlf_surface_commit(struct wlf_surface *surface)
+{
+    wlf_surface_ack_configure(surface);
+
+    if (surface->damage.attached) {
+        struct wlf_region region;
+        wlf_surface_take_damage(surface, &region);
+
+        for (uint32_t i = 0; i < region.count; ++i) {
+            const struct wlf_rect *r = &region.rects[i];
+            wl_surface_damage_buffer(
+                surface->wl_surface,
+                r->offset.x,
+                r->offset.y,
+                r->extent.width,
+                r->extent.height);
+        }
+    }
+
+    wl_surface_commit(surface->wl_surface);
+}
+
+// Sends a deferred ack. Needed before commits wleaf does not see, e.g. from
+// vkQueuePresentKHR.
+// Runs right before every commit made through wleaf, which is when feedback
+// requested since the previous one is submitted.
+void
+wlf_surface_ack_configure(struct wlf_surface *surface)
+{
+    int64_t now = 0;
+    struct wlf_feedback *feedback;
+    wl_list_for_each_reverse(feedback, &surface->feedback_list, link) {
+        if (feedback->commit_time != 0) {
+            break;
+        }
+        if (now == 0) {
+            now = wlf_get_clock_ns(surface->context->presentation_clock);
+        }
+        feedback->commit_time = now;
+    }
+
+    if (surface->ack_pending) {
+        surface->ack_pending = false;
+        surface->send_ack(surface, surface->ack_serial);
+    }
+}
+
+// The rect is in surface-local coordinates.
+enum wlf_result
+wlf_surface_add_damage(struct wlf_surface *surface, struct wlf_rect rect)
+{
+    wlf_surface_sync_damage(surface);
+
+    struct wlf_extent extent = wlf_surface_get_extent(surface);
+    int32_t x0 = rect.offset.x < 0 ? 0 : rect.offset.x;
+    int32_t y0 = rect.offset.y < 0 ? 0 : rect.offset.y;
+    int64_t x1 = (int64_t)rect.offset.x + rect.extent.width;
+    int64_t y1 = (int64_t)rect.offset.y + rect.extent.height;
+    x1 = x1 > extent.width ? extent.width : x1;
+    y1 = y1 > extent.height ? extent.height : y1;
+
+    if (x1 <= x0 || y1 <= y0) {
+        return WLF_SKIPPED;
+    }
+
+    struct wlf_rect clipped = {
+        .offset = { x0, y0 },
+        .extent = { (int32_t)(x1 - x0), (int32_t)(y1 - y0) },
+    };
+    wlf_region_add(&surface->damage.pending, wlf_surface_rect_to_buffer(surface, clipped));
+    return WLF_SUCCESS;
+}
+
+// Returns the buffer-local rects to repaint into a buffer of the given age,
+// as defined by EGL_EXT_buffer_age. The region is coarsened to fit *count.
+enum wlf_result
+wlf_surface_get_repaint_region(
+    struct wlf_surface *surface,
+    uint32_t buffer_age,
+    struct wlf_rect *rects,
+    uint32_t *count)
+{
+    if (*count == 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    wlf_surface_sync_damage(surface);
+
+    struct wlf_region region;
+    if (!wlf_damage_get_region(&surface->damage, buffer_age, &region)) {
+        rects[0] = (struct wlf_rect) { .extent = surface->damage.extent };
+        *count = 1;
+        return WLF_SUCCESS;
+    }
+
+    wlf_region_reduce(&region, *count);
+    memcpy(rects, region.rects, region.count * sizeof(struct wlf_rect));
+    *count = region.count;
+    return WLF_SUCCESS;
+}
+
+// The callback is part of the pending state and takes effect with the next
+// commit, so this has to be called before the buffer is presented.
+enum wlf_result
+wlf_surface_request_frame(struct wlf_surface *surface)
+{
+    if (surface->frame_callback || surface->frame_deferred || surface->frame_scheduled) {
+        return WLF_ALREADY_SET;
+    }
+
+    surface->frame_callback = wl_surface_frame(surface->wl_surface);
+    if (!surface->frame_callback) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    wl_callback_add_listener(surface->frame_callback, &wl_frame_listener, surface);
+
+    if (surface->frame_mode == WLF_FRAME_MODE_DEADLINE) {
+        wlf_surface_update_render_cost(surface);
+
+        // Presentation feedback keeps the vblank prediction in phase.
+        if (surface->context->wp_presentation && wl_list_empty(&surface->feedback_list)) {
+            wlf_surface_request_feedback(surface);
+        }
+    }
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_surface_set_frame_mode(struct wlf_surface *surface, enum wlf_frame_mode mode)
+{
+    switch (mode) {
+        case WLF_FRAME_MODE_CALLBACK:
+            if (surface->frame_timer) {
+                wlf_source_remove(surface->frame_timer);
+                surface->frame_timer = nullptr;
+            }
+            surface->frame_mode = mode;
+            if (surface->frame_scheduled) {
+                surface->frame_scheduled = false;
+                wlf_surface_emit_frame(surface, surface->frame_time);
+            }
+            return WLF_SUCCESS;
+        case WLF_FRAME_MODE_DEADLINE:
+            // The timer runs on the context loop, which wlf_surface_dispatch()
+            // does not service.
+            if (surface->wl_event_queue) {
+                return WLF_ERROR_UNSUPPORTED;
+            }
+            if (!surface->frame_timer) {
+                surface->frame_timer = wlf_loop_add_timer(
+                    &surface->context->loop,
+                    wlf_surface_frame_timer,
+                    surface);
+                if (!surface->frame_timer) {
+                    return WLF_ERROR_UNKNOWN;
+                }
+            }
+            surface->frame_mode = mode;
+            surface->render_cost = 0;
+            return WLF_SUCCESS;
+        default:
+            return WLF_ERROR_INVALID_ARGUMENT;
+    }
+}
+
+// Like frame callbacks, feedback applies to the next commit.
+enum wlf_result
+wlf_surface_request_feedback(struct wlf_surface *surface)
+{
+    struct wlf_context *context = surface->context;
+    if (!context->wp_presentation) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    struct wlf_feedback *feedback = calloc(1, sizeof(*feedback));
+    if (!feedback) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    struct wp_presentation *presentation = wlf_surface_wrap_proxy(surface, context->wp_presentation);
+    if (!presentation) {
+        free(feedback);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    feedback->wp_feedback = wp_presentation_feedback(presentation, surface->wl_surface);
+    wlf_surface_unwrap_proxy(surface, presentation);
+    if (!feedback->wp_feedback) {
+        free(feedback);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    feedback->surface = surface;
+    wp_presentation_feedback_add_listener(
+        feedback->wp_feedback,
+        &wp_presentation_feedback_listener,
+        feedback);
+    wl_list_insert(surface->feedback_list.prev, &feedback->link);
+    return WLF_SUCCESS;
+}
+
+enum wlf_result
+wlf_surface_get_presentation_stats(struct wlf_surface *surface, struct wlf_presentation_stats *stats)
+{
+    if (!surface->context->wp_presentation) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    const struct wlf_presentation_history *history = &surface->presentation;
+
+    stats->presented = history->presented;
+    stats->discarded = history->discarded;
+    stats->missed = history->missed;
+    stats->refresh = history->refresh;
+    stats->latency_p50 = 0;
+    stats->latency_p90 = 0;
+    stats->latency_p99 = 0;
+
+    uint32_t n = history->latency_count;
+    if (n == 0) {
+        return WLF_SUCCESS;
+    }
+
+    int64_t sorted[WLF_PRESENTATION_HISTORY];
+    memcpy(sorted, history->latency, n * sizeof(int64_t));
+    qsort(sorted, n, sizeof(int64_t), wlf_compare_i64);
+
+    stats->latency_p50 = sorted[(n - 1) * 50 / 100];
+    stats->latency_p90 = sorted[(n - 1) * 90 / 100];
+    stats->latency_p99 = sorted[(n - 1) * 99 / 100];
+    return WLF_SUCCESS;
+}
+
 enum wlf_result
 wlf_surface_inhibit_idling(struct wlf_surface *surface, bool enable)
 {
@@ -300,6 +1333,9 @@ wlf_surface_inhibit_idling(struct wlf_surface *surface, bool enable)
 enum wlf_result
 wlf_surface_set_content_type(struct wlf_surface *surface, enum wlf_content_type type)
 {
+    surface->content_type = type;
+    wlf_surface_update_auto_tearing(surface);
+
     if (!surface->wp_content_type_v1) {
         return WLF_ERROR_UNSUPPORTED;
     }
@@ -317,6 +1353,140 @@ wlf_surface_set_alpha_multiplier(struct wlf_surface *surface, uint32_t factor)
     return WLF_SUCCESS;
 }
 
+enum wlf_result
+wlf_surface_dispatch(struct wlf_surface *surface, int64_t timeout)
+{
+    struct wl_event_queue *queue = surface->wl_event_queue;
+    if (!queue) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+    if (surface->context->lost) {
+        return WLF_ERROR_LOST;
+    }
+
+    struct wl_display *wl_display = surface->context->wl_display;
+
+    if (wl_display_prepare_read_queue(wl_display, queue) < 0) {
+        int n = wl_display_dispatch_queue_pending(wl_display, queue);
+        if (n < 0) {
+            return WLF_ERROR_WAYLAND;
+        }
+        wlf_surface_flush_configure(surface);
+        return WLF_SUCCESS;
+    }
+
+    int n = wlf_context_try_flush(surface->context);
+    if (n < 0) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_WAYLAND;
+    }
+
+    struct pollfd fds[1];
+    fds[0].fd = wl_display_get_fd(wl_display);
+    fds[0].events = n > 0 ? POLLIN | POLLOUT : POLLIN;
+
+    n = wlf_poll(fds, 1, timeout);
+    if (n < 0) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_WAYLAND;
+    }
+
+    if ((fds[0].revents & POLLOUT) && wlf_context_try_flush(surface->context) < 0) {
+        wl_display_cancel_read(wl_display);
+        return WLF_ERROR_WAYLAND;
+    }
+
+    // Events read here for other queues are left for their own dispatchers.
+    if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+        n = wl_display_read_events(wl_display);
+        if (n < 0) {
+            return WLF_ERROR_WAYLAND;
+        }
+    } else {
+        wl_display_cancel_read(wl_display);
+    }
+
+    n = wl_display_dispatch_queue_pending(wl_display, queue);
+    if (n < 0) {
+        return WLF_ERROR_WAYLAND;
+    }
+
+    wlf_surface_flush_configure(surface);
+    return WLF_SUCCESS;
+}
+
+// Explicitly setting a hint overrides the automatic policy of the toplevel.
+enum wlf_result
+wlf_surface_set_presentation_hint(struct wlf_surface *surface, enum wlf_presentation_hint hint)
+{
+    if (hint != WLF_PRESENTATION_HINT_VSYNC && hint != WLF_PRESENTATION_HINT_ASYNC) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+    surface->auto_tearing = false;
+    return wlf_surface_apply_presentation_hint(surface, hint);
+}
+
+// The barrier is set by the next commit and cleared once its content is
+// latched by the compositor.
+enum wlf_result
+wlf_surface_set_fifo_barrier(struct wlf_surface *surface)
+{
+    if (!surface->context->wp_fifo_manager_v1) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    struct wp_fifo_v1 *fifo = wlf_surface_get_fifo(surface);
+    if (!fifo) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    wp_fifo_v1_set_barrier(fifo);
+    return WLF_SUCCESS;
+}
+
+// Holds the next commit in the compositor until the barrier is cleared
+// instead of blocking the caller.
+enum wlf_result
+wlf_surface_wait_fifo_barrier(struct wlf_surface *surface)
+{
+    if (!surface->context->wp_fifo_manager_v1) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    struct wp_fifo_v1 *fifo = wlf_surface_get_fifo(surface);
+    if (!fifo) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    wp_fifo_v1_wait_barrier(fifo);
+    return WLF_SUCCESS;
+}
+
+// The time is in the presentation clock domain and at most one timestamp
+// may be set per commit.
+enum wlf_result
+wlf_surface_set_present_time(struct wlf_surface *surface, int64_t time)
+{
+    if (!surface->context->wp_commit_timing_manager_v1) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+
+    if (time < 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct wp_commit_timer_v1 *timer = wlf_surface_get_commit_timer(surface);
+    if (!timer) {
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint64_t sec = (uint64_t)(time / 1'000'000'000);
+    wp_commit_timer_v1_set_timestamp(
+        timer,
+        (uint32_t)(sec >> 32),
+        (uint32_t)sec,
+        (uint32_t)(time % 1'000'000'000));
+    return WLF_SUCCESS;
+}
+
 struct wlf_offset
 wlf_surface_point_to_buffer_offset(struct wlf_surface *surface, struct wlf_point point)
 {
@@ -325,11 +1495,7 @@ wlf_surface_point_to_buffer_offset(struct wlf_surface *surface, struct wlf_point
 
     struct wlf_point tp = wlf_point_transform(point, extent, rev);
 
-    double scale = surface->scale;
-
-    if (surface->wp_fractional_scale_v1) {
-        scale /= 120.0;
-    }
+    double scale = wlf_surface_get_buffer_factor(surface);
     tp.x *= scale;
     tp.y *= scale;
 
@@ -2,21 +2,51 @@
 
 #include <wlf/surface.h>
 
+#include "context_priv.h"
+#include "damage_priv.h"
+
 struct wlf_output;
 
+constexpr uint32_t WLF_PRESENTATION_HISTORY = 128;
+
+struct wlf_feedback {
+    struct wl_list link;
+    struct wlf_surface *surface;
+    struct wp_presentation_feedback *wp_feedback;
+    int64_t commit_time;
+};
+
+struct wlf_presentation_history {
+    uint64_t presented;
+    uint64_t discarded;
+    uint64_t missed;
+    int64_t last_time;
+    int64_t refresh;
+    int64_t latency[WLF_PRESENTATION_HISTORY];
+    uint32_t latency_count;
+    uint32_t latency_next;
+};
+
 enum wlf_surface_type : uint32_t {
     WLF_SURFACE_TYPE_TOPLEVEL = 1,
     WLF_SURFACE_TYPE_POPUP = 2,
+    WLF_SURFACE_TYPE_SUBSURFACE = 3,
 };
 
 struct wlf_surface {
     enum wlf_surface_type type;
     struct wlf_context *context;
+    struct wlf_surface_listener listener;
 
     struct wlf_extent extent;
     int32_t scale;
     enum wlf_transform transform;
 
+    // Percentage of the full resolution buffers are rendered at, 0 when the
+    // buffer extent follows the surface.
+    uint32_t render_scale;
+
+    struct wl_event_queue               *wl_event_queue;
     struct wl_surface                   *wl_surface;
     struct wl_egl_window                *wl_egl_window;
     struct wp_viewport                  *wp_viewport;
@@ -24,30 +54,143 @@ struct wlf_surface {
     struct wp_content_type_v1           *wp_content_type_v1;
     struct zwp_idle_inhibitor_v1        *wp_idle_inhibitor_v1;
     struct wp_alpha_modifier_surface_v1 *wp_alpha_modifier_surface_v1;
+    struct wp_tearing_control_v1        *wp_tearing_control_v1;
+    struct wp_fifo_v1                   *wp_fifo_v1;
+    struct wp_commit_timer_v1           *wp_commit_timer_v1;
+    struct wl_callback                  *frame_callback;
+    struct wlf_dmabuf_state             *dmabuf_feedback;
+
+    // The viewport destination tracks the surface extent.
+    bool viewport_sized;
+
+    // Overrides the viewport destination while the buffer is stretched.
+    struct wlf_extent viewport_extent;
+
+    // Frame ticks are held back while the surface is suspended.
+    bool suspended;
+    bool frame_deferred;
+
+    enum wlf_content_type content_type;
+    enum wlf_presentation_hint presentation_hint;
+
+    // Selects async presentation for fullscreen game content.
+    bool auto_tearing;
+    bool fullscreen;
+
+    // Paces the EGL swap helpers with a FIFO barrier. Only one wp_fifo_v1 may
+    // exist per surface, so this must not be combined with a swap interval
+    // the driver paces itself.
+    bool fifo;
+
+    enum wlf_frame_mode frame_mode;
+    struct wlf_source *frame_timer;
+    bool frame_scheduled;
+    uint32_t frame_time;
+    int64_t frame_emit_time;
+    int64_t render_cost;
 
     struct wl_list link;
-    struct wl_list output_list;
+    // Entered outputs by slot, kept in sync with the per-output surface arrays.
+    // Guarded by the context output lock.
+    uint64_t output_mask;
+    uint32_t output_index[WLF_OUTPUT_SLOT_COUNT];
+    // Enter order of each output, slots are reused after hotplug.
+    uint32_t output_entered[WLF_OUTPUT_SLOT_COUNT];
+    uint32_t output_enter_count;
+    int32_t max_scale;
+    struct wlf_output *primary_output;
+    // Last max_scale applied by the thread dispatching the surface.
+    int32_t output_scale;
+    struct wl_list feedback_list;
+    struct wlf_presentation_history presentation;
+    struct wlf_damage damage;
+
+    // Configures received during a dispatch are applied once it completes,
+    // so only the latest state reaches the application.
+    bool configure_queued;
+    uint32_t configure_serial;
+    struct wl_list configure_link;
+
+    // The ack is held back until the next commit instead of sent right away.
+    bool defer_ack;
+    bool ack_pending;
+    uint32_t ack_serial;
 
     // void (*enter)(struct wlf_surface *surface, struct wlf_output *output);
     // void (*leave)(struct wlf_surface *surface, struct wlf_output *output);
 
     void (*configure_scale)(struct wlf_surface *surface, int32_t scale);
     void (*configure_transform)(struct wlf_surface *surface, enum wlf_transform transform);
+    void (*configure)(struct wlf_surface *surface, uint32_t serial);
+    void (*send_ack)(struct wlf_surface *surface, uint32_t serial);
 
     void *user_data;
 };
 
+void
+wlf_surface_schedule_flush(struct wlf_surface *surface);
+
+void
+wlf_surface_sync_output_scale(struct wlf_surface *surface);
+
+void
+wlf_surface_handle_output_changed(struct wlf_surface *s, struct wlf_output *o);
+
 void
 wlf_surface_handle_output_destroyed(struct wlf_surface *s, struct wlf_output *o);
 
+void
+wlf_surface_set_suspended(struct wlf_surface *surface, bool suspended);
+
+void
+wlf_surface_set_fullscreen(struct wlf_surface *surface, bool fullscreen);
+
 struct wlf_extent
 wlf_surface_get_extent(struct wlf_surface *surface);
 
 struct wlf_extent
 wlf_surface_get_buffer_extent(struct wlf_surface *surface);
 
+struct wlf_extent
+wlf_surface_compute_buffer_extent(
+    struct wlf_surface *surface,
+    struct wlf_extent extent,
+    int32_t scale,
+    enum wlf_transform transform);
+
+int64_t
+wlf_surface_get_refresh(struct wlf_surface *surface);
+
+void
+wlf_surface_update_viewport(struct wlf_surface *surface);
+
+void
+wlf_surface_stretch_viewport(struct wlf_surface *surface, struct wlf_extent extent);
+
+void
+wlf_surface_take_damage(struct wlf_surface *surface, struct wlf_region *region);
+
+void
+wlf_surface_queue_configure(struct wlf_surface *surface, uint32_t serial);
+
+void
+wlf_surface_flush_configure(struct wlf_surface *surface);
+
+void
+wlf_surface_ack(struct wlf_surface *surface, uint32_t serial);
+
+void *
+wlf_surface_wrap_proxy(struct wlf_surface *surface, void *proxy);
+
+void
+wlf_surface_unwrap_proxy(struct wlf_surface *surface, void *wrapper);
+
 enum wlf_result
-wlf_surface_init(struct wlf_context *context, enum wlf_surface_type type, struct wlf_surface *surface);
+wlf_surface_init(
+    struct wlf_context *context,
+    enum wlf_surface_type type,
+    bool event_queue,
+    struct wlf_surface *surface);
 
 void
 wlf_surface_fini(struct wlf_surface *surface);
@@ -14,7 +14,12 @@
 #include "common_priv.h"
 #include "context_priv.h"
 #include "input_priv.h"
+#include "output_priv.h"
 #include "toplevel_priv.h"
+#include "loop_priv.h"
+#include "trace_priv.h"
+
+constexpr int64_t WLF_TOPLEVEL_RESIZE_IDLE = 150'000'000;
 
 [[maybe_unused]]
 static struct wlf_rect
@@ -26,6 +31,140 @@ wlf_toplevel_get_geometry(struct wlf_toplevel *tl)
     };
 }
 
+static bool
+wlf_toplevel_is_stretched(struct wlf_toplevel *tl)
+{
+    return tl->s.viewport_extent.width > 0;
+}
+
+// Shows the window right away while the first real buffer is prepared. It
+// is committed before the application draws, so it never covers that frame.
+static void
+wlf_toplevel_show_placeholder(struct wlf_toplevel *tl)
+{
+    tl->placeholder_pending = false;
+
+    wlf_surface_ack(&tl->s, tl->placeholder_serial);
+    wlf_surface_ack_configure(&tl->s);
+
+    if (wlf_surface_attach_solid_color(&tl->s, tl->placeholder_color) == WLF_SUCCESS) {
+        wl_surface_commit(tl->s.wl_surface);
+    }
+}
+
+static void
+wlf_toplevel_resize_buffer(struct wlf_toplevel *tl)
+{
+    struct wlf_extent be = wlf_surface_get_buffer_extent(&tl->s);
+
+    if (tl->s.wl_egl_window) {
+        wl_egl_window_resize(tl->s.wl_egl_window, be.width, be.height, 0, 0);
+    }
+
+    if (wlf_toplevel_is_stretched(tl)) {
+        wlf_source_arm_timer(tl->resize_timer, -1, 0);
+        wlf_surface_stretch_viewport(&tl->s, (struct wlf_extent) { 0, 0 });
+    } else {
+        wlf_surface_update_viewport(&tl->s);
+    }
+
+    if (tl->placeholder_pending) {
+        wlf_toplevel_show_placeholder(tl);
+    }
+
+    wlf_trace_configure(tl->s.context);
+    tl->listener.configure(tl->s.user_data, be);
+}
+
+static void
+wlf_toplevel_resize_timer(void *data)
+{
+    struct wlf_toplevel *tl = data;
+    if (wlf_toplevel_is_stretched(tl)) {
+        tl->s.extent = tl->current.extent;
+        wlf_toplevel_resize_buffer(tl);
+    }
+}
+
+static void
+wlf_toplevel_check_prediction(struct wlf_toplevel *tl)
+{
+    if (tl->predicted.width == 0) {
+        return;
+    }
+
+    struct wlf_extent be = wlf_surface_get_buffer_extent(&tl->s);
+    if (wlf_extent_equal(be, tl->predicted)) {
+        wlf_trace_count(tl->s.context, WLF_COUNTER_PREDICTION_HITS);
+    } else {
+        wlf_trace_count(tl->s.context, WLF_COUNTER_PREDICTION_MISSES);
+    }
+}
+
+// New windows usually open on the focused output, which clients cannot
+// know; the highest scale one is assumed.
+static struct wlf_output *
+wlf_toplevel_guess_output(struct wlf_toplevel *tl)
+{
+    struct wlf_output *best = nullptr;
+    struct wlf_output *output;
+    wl_list_for_each(output, &tl->s.context->output_list, link) {
+        if (!best || wlf_output_get_scale(output) > wlf_output_get_scale(best)) {
+            best = output;
+        }
+    }
+    return best;
+}
+
+static struct wlf_extent
+wlf_toplevel_predict_extent(struct wlf_toplevel *tl)
+{
+    struct wlf_extent extent = tl->current.extent;
+    if (tl->events & WLF_TOPLEVEL_EVENT_EXTENT) {
+        if (tl->pending.extent.width > 0) {
+            extent.width = tl->pending.extent.width;
+        }
+        if (tl->pending.extent.height > 0) {
+            extent.height = tl->pending.extent.height;
+        }
+    }
+
+    // Compositors tend to shrink initial sizes that do not fit the bounds.
+    struct wlf_extent bounds = tl->events & WLF_TOPLEVEL_EVENT_BOUNDS
+                             ? tl->pending.bounds
+                             : tl->current.bounds;
+    if (bounds.width > 0 && extent.width > bounds.width) {
+        extent.width = bounds.width;
+    }
+    if (bounds.height > 0 && extent.height > bounds.height) {
+        extent.height = bounds.height;
+    }
+
+    int32_t scale = tl->current.scale;
+    enum wlf_transform transform = tl->current.transform;
+
+    struct wlf_output *output = wlf_toplevel_guess_output(tl);
+    if (output) {
+        scale = tl->s.wp_fractional_scale_v1
+              ? wlf_output_get_fractional_scale(output)
+              : wlf_output_get_scale(output);
+#ifdef WL_SURFACE_PREFERRED_BUFFER_TRANSFORM_SINCE_VERSION
+        if (wl_surface_get_version(tl->s.wl_surface) >= WL_SURFACE_PREFERRED_BUFFER_TRANSFORM_SINCE_VERSION) {
+            transform = output->transform;
+        }
+#endif
+    }
+
+    if (tl->events & WLF_TOPLEVEL_EVENT_SCALE) {
+        scale = tl->pending.scale;
+    }
+    if (tl->events & WLF_TOPLEVEL_EVENT_TRANSFORM) {
+        transform = tl->pending.transform;
+    }
+
+    return wlf_surface_compute_buffer_extent(&tl->s, extent, scale, transform);
+}
+
 static void
 wlf_toplevel_configure(struct wlf_toplevel *tl, uint32_t serial)
 {
@@ -41,6 +180,8 @@ wlf_toplevel_configure(struct wlf_toplevel *tl, uint32_t serial)
 
     if (mask & WLF_TOPLEVEL_EVENT_STATE) {
         tl->current.state = tl->pending.state;
+        wlf_surface_set_suspended(&tl->s, tl->current.state & WLF_TOPLEVEL_STATE_SUSPENDED);
+        wlf_surface_set_fullscreen(&tl->s, tl->current.state & WLF_TOPLEVEL_STATE_FULLSCREEN);
     }
 
     if (mask & WLF_TOPLEVEL_EVENT_BOUNDS) {
@@ -79,28 +220,36 @@ wlf_toplevel_configure(struct wlf_toplevel *tl, uint32_t serial)
     // TODO: Temporary
     tl->s.scale = tl->current.scale;
     tl->s.transform = tl->current.transform;
-    tl->s.extent = tl->current.extent;
 
     tl->events = WLF_TOPLEVEL_EVENT_NONE;
 
-    if (resized || !tl->configured) {
-        struct wlf_extent se = wlf_surface_get_extent(&tl->s);
-        struct wlf_extent be = wlf_surface_get_buffer_extent(&tl->s);
-
-        if (tl->s.wl_egl_window) {
-            wl_egl_window_resize(tl->s.wl_egl_window, be.width, be.height, 0, 0);
-        }
+    // While the compositor drives an interactive resize the current buffer is
+    // stretched to the new extent, so the application reallocates only once
+    // the resize ends or goes idle instead of on every configure.
+    bool stretch = resized && tl->resize_timer && tl->configured && !rescaled && !transformed
+                && (tl->current.state & WLF_TOPLEVEL_STATE_RESIZING);
+    if (stretch) {
+        wlf_surface_stretch_viewport(&tl->s, tl->current.extent);
+        wlf_source_arm_timer(tl->resize_timer, WLF_TOPLEVEL_RESIZE_IDLE, 0);
+        resized = false;
+    } else {
+        resized |= wlf_toplevel_is_stretched(tl);
+        tl->s.extent = tl->current.extent;
+    }
 
-        if (tl->s.wp_fractional_scale_v1) {
-            assert(tl->s.wp_viewport);
-            wp_viewport_set_destination(tl->s.wp_viewport, se.width, se.height);
+    if (resized || !tl->configured) {
+        if (!tl->configured) {
+            wlf_trace_frame(tl->s.context, tl->s.wl_surface);
+            wlf_toplevel_check_prediction(tl);
         }
 
-        tl->listener.configure(tl->s.user_data, be);
+        wlf_toplevel_resize_buffer(tl);
     }
 
+    // Buffers of a fixed extent toplevel are sized freely and scaled by the
+    // viewport, so the buffer scale stays at 1.
     uint32_t version = wl_surface_get_version(tl->s.wl_surface);
-    if (rescaled && !tl->s.wp_fractional_scale_v1) {
+    if (rescaled && !tl->s.wp_fractional_scale_v1 && tl->s.render_scale == 0) {
         assert(version >= WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION);
         wl_surface_set_buffer_scale(tl->s.wl_surface, tl->current.scale);
     }
@@ -275,13 +424,7 @@ static void
 xdg_surface_configure(void *data, struct xdg_surface *xdg_surface, uint32_t serial)
 {
     struct wlf_toplevel *toplevel = data;
-
-    if (toplevel->events != WLF_TOPLEVEL_EVENT_NONE || !toplevel->configured) {
-        wlf_toplevel_configure(toplevel, serial);
-    }
-
-    xdg_surface_ack_configure(toplevel->xdg_surface, serial);
-    toplevel->configured = true;
+    wlf_surface_queue_configure(&toplevel->s, serial);
 }
 
 static const struct xdg_surface_listener xdg_surface_listener = {
@@ -292,6 +435,39 @@ static const struct xdg_surface_listener xdg_surface_listener = {
 
 // region Surface
 
+static void
+wlf_toplevel_handle_configure(struct wlf_surface *surface, uint32_t serial)
+{
+    struct wlf_toplevel *toplevel = wl_container_of(surface, toplevel, s);
+
+    bool placeholder = !toplevel->configured && toplevel->placeholder;
+    toplevel->placeholder_pending = placeholder;
+    toplevel->placeholder_serial = serial;
+
+    if (toplevel->events != WLF_TOPLEVEL_EVENT_NONE || !toplevel->configured) {
+        wlf_toplevel_configure(toplevel, serial);
+    }
+
+    // The placeholder acks the serial itself.
+    if (toplevel->placeholder_pending) {
+        wlf_toplevel_show_placeholder(toplevel);
+    } else if (!placeholder) {
+        wlf_surface_ack(&toplevel->s, serial);
+    }
+
+    if (!toplevel->configured) {
+        wlf_trace_end(toplevel->s.context, WLF_TIMING_FIRST_CONFIGURE);
+    }
+    toplevel->configured = true;
+}
+
+static void
+wlf_toplevel_send_ack(struct wlf_surface *surface, uint32_t serial)
+{
+    struct wlf_toplevel *toplevel = wl_container_of(surface, toplevel, s);
+    xdg_surface_ack_configure(toplevel->xdg_surface, serial);
+}
+
 static void
 wlf_toplevel_configure_scale(struct wlf_surface *surface, int32_t scale)
 {
@@ -377,13 +553,34 @@ wlf_toplevel_init_state(struct wlf_toplevel *toplevel, const struct wlf_toplevel
         wlf_toplevel_set_decoration_mode(toplevel, info->decoration_mode);
     }
 
-    if (info->content_type != WLF_CONTENT_TYPE_NONE && toplevel->s.wp_content_type_v1) {
+    toplevel->s.auto_tearing = info->flags & WLF_TOPLEVEL_FLAGS_AUTO_TEARING;
+    toplevel->placeholder = info->flags & WLF_TOPLEVEL_FLAGS_PLACEHOLDER;
+    toplevel->placeholder_color = info->placeholder_color;
+
+    if (info->content_type != WLF_CONTENT_TYPE_NONE) {
         wlf_surface_set_content_type(&toplevel->s, info->content_type);
     }
 
     if (info->flags & WLF_TOPLEVEL_FLAGS_INHIBIT_IDLING && toplevel->s.wp_idle_inhibitor_v1) {
         wlf_surface_inhibit_idling(&toplevel->s, true);
     }
+
+    if (info->flags & WLF_TOPLEVEL_FLAGS_FIXED_BUFFER_EXTENT && toplevel->s.wp_viewport) {
+        wlf_governor_init(&toplevel->governor);
+        toplevel->s.render_scale = toplevel->governor.scale;
+        toplevel->s.viewport_sized = true;
+    }
+
+    // The idle timer runs on the context loop, which toplevels with their own
+    // queue are not dispatched from, so those keep reallocating on resize.
+    if (info->flags & WLF_TOPLEVEL_FLAGS_VIEWPORT_RESIZE && toplevel->s.wp_viewport &&
+        !toplevel->s.wl_event_queue)
+    {
+        toplevel->resize_timer = wlf_loop_add_timer(
+            &toplevel->s.context->loop,
+            wlf_toplevel_resize_timer,
+            toplevel);
+    }
 }
 
 static enum wlf_result
@@ -393,27 +590,43 @@ wlf_toplevel_init(
     const struct wlf_toplevel_listener *listener,
     struct wlf_toplevel *toplevel)
 {
-    enum wlf_result res = wlf_surface_init(context, WLF_SURFACE_TYPE_TOPLEVEL, &toplevel->s);
+    enum wlf_result res = wlf_surface_init(
+        context,
+        WLF_SURFACE_TYPE_TOPLEVEL,
+        info->flags & WLF_TOPLEVEL_FLAGS_EVENT_QUEUE,
+        &toplevel->s);
     if (res < WLF_SUCCESS) {
         return res;
     }
 
     toplevel->s.configure_scale = wlf_toplevel_configure_scale,
     toplevel->s.configure_transform = wlf_toplevel_configure_transform,
+    toplevel->s.configure = wlf_toplevel_handle_configure;
+    toplevel->s.send_ack = wlf_toplevel_send_ack;
+    toplevel->s.defer_ack = info->flags & WLF_TOPLEVEL_FLAGS_DEFERRED_ACK;
+    toplevel->s.fifo = info->flags & WLF_TOPLEVEL_FLAGS_FIFO;
     toplevel->s.user_data = info->user_data;
     toplevel->listener = *listener;
 
-    toplevel->xdg_surface = xdg_wm_base_get_xdg_surface(
-        context->xdg_wm_base, toplevel->s.wl_surface);
+    struct xdg_wm_base *wm_base = wlf_surface_wrap_proxy(&toplevel->s, context->xdg_wm_base);
+    if (!wm_base) {
+        wlf_surface_fini(&toplevel->s);
+        return WLF_ERROR_OUT_OF_MEMORY;
+    }
+    toplevel->xdg_surface = xdg_wm_base_get_xdg_surface(wm_base, toplevel->s.wl_surface);
+    wlf_surface_unwrap_proxy(&toplevel->s, wm_base);
     xdg_surface_add_listener(toplevel->xdg_surface, &xdg_surface_listener, toplevel);
 
     toplevel->xdg_toplevel = xdg_surface_get_toplevel(toplevel->xdg_surface);
     xdg_toplevel_add_listener(toplevel->xdg_toplevel, &xdg_toplevel_listener, toplevel);
 
-    if (context->xdg_decoration_manager_v1) {
+    struct zxdg_decoration_manager_v1 *decoration_manager
+        = wlf_surface_wrap_proxy(&toplevel->s, context->xdg_decoration_manager_v1);
+    if (decoration_manager) {
         toplevel->xdg_toplevel_decoration_v1 = zxdg_decoration_manager_v1_get_toplevel_decoration(
-            context->xdg_decoration_manager_v1,
+            decoration_manager,
             toplevel->xdg_toplevel);
+        wlf_surface_unwrap_proxy(&toplevel->s, decoration_manager);
         zxdg_toplevel_decoration_v1_add_listener(
             toplevel->xdg_toplevel_decoration_v1,
             &xdg_toplevel_decoration_v1_listener,
@@ -430,6 +643,9 @@ wlf_toplevel_init(
     }
 
     wlf_toplevel_init_state(toplevel, info);
+
+    wlf_trace_begin(context, WLF_TIMING_FIRST_CONFIGURE);
+    wlf_trace_begin(context, WLF_TIMING_FIRST_FRAME);
     wl_surface_commit(toplevel->s.wl_surface);
 
     return WLF_SUCCESS;
@@ -438,6 +654,9 @@ wlf_toplevel_init(
 static void
 wlf_toplevel_fini(struct wlf_toplevel *toplevel)
 {
+    if (toplevel->resize_timer) {
+        wlf_source_remove(toplevel->resize_timer);
+    }
     if (toplevel->xdg_toplevel_decoration_v1) {
         zxdg_toplevel_decoration_v1_destroy(toplevel->xdg_toplevel_decoration_v1);
     }
@@ -458,6 +677,12 @@ wlf_toplevel_create(
     const struct wlf_toplevel_listener *listener,
     struct wlf_toplevel **_toplevel)
 {
+    if (!context->ready) {
+        return WLF_ERROR_UNINITIALIZED;
+    }
+    if (context->lost) {
+        return WLF_ERROR_LOST;
+    }
     if (!context->xdg_wm_base) {
         return WLF_ERROR_UNSUPPORTED;
     }
@@ -500,6 +725,19 @@ wlf_toplevel_from_surface(struct wlf_surface *surface)
     return t;
 }
 
+// Best guess of the buffer extent of the first configure, so buffers can be
+// allocated before it arrives. Once configured this is the buffer extent.
+struct wlf_extent
+wlf_toplevel_get_predicted_extent(struct wlf_toplevel *toplevel)
+{
+    if (toplevel->configured) {
+        return wlf_surface_get_buffer_extent(&toplevel->s);
+    }
+
+    toplevel->predicted = wlf_toplevel_predict_extent(toplevel);
+    return toplevel->predicted;
+}
+
 void
 wlf_toplevel_set_parent(struct wlf_toplevel *toplevel, struct wlf_toplevel *parent)
 {
@@ -661,4 +899,56 @@ wlf_toplevel_set_dialog_modal(struct wlf_toplevel *toplevel, bool set)
     return WLF_SUCCESS;
 }
 
+enum wlf_result
+wlf_toplevel_set_target_frame_time(struct wlf_toplevel *toplevel, int64_t frame_time)
+{
+    if (toplevel->s.render_scale == 0) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+    if (frame_time < 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+    toplevel->target_frame_time = frame_time;
+    return WLF_SUCCESS;
+}
+
+// Frame times are the CPU or GPU time the application spent on a frame. The
+// render scale is adjusted in steps to keep them within the target, which
+// defaults to the refresh interval of the output.
+enum wlf_result
+wlf_toplevel_report_frame_time(struct wlf_toplevel *toplevel, int64_t frame_time)
+{
+    if (toplevel->s.render_scale == 0) {
+        return WLF_ERROR_UNSUPPORTED;
+    }
+    if (frame_time <= 0) {
+        return WLF_ERROR_INVALID_ARGUMENT;
+    }
+
+    int64_t target = toplevel->target_frame_time;
+    if (target == 0) {
+        target = wlf_surface_get_refresh(&toplevel->s);
+    }
+    if (target <= 0) {
+        target = 1'000'000'000 / 60;
+    }
+
+    if (!wlf_governor_update(&toplevel->governor, frame_time, target)) {
+        return WLF_SKIPPED;
+    }
+
+    toplevel->s.render_scale = toplevel->governor.scale;
+    if (toplevel->configured) {
+        toplevel->s.extent = toplevel->current.extent;
+        wlf_toplevel_resize_buffer(toplevel);
+    }
+    return WLF_SUCCESS;
+}
+
+uint32_t
+wlf_toplevel_get_render_scale(struct wlf_toplevel *toplevel)
+{
+    return toplevel->s.render_scale > 0 ? toplevel->s.render_scale : 100;
+}
+
 // endregion
@@ -2,6 +2,7 @@
 
 #include "wlf/toplevel.h"
 #include "surface_priv.h"
+#include "governor_priv.h"
 
 enum wlf_toplevel_event : uint32_t {
     WLF_TOPLEVEL_EVENT_NONE = 0,
@@ -56,4 +57,19 @@ struct wlf_toplevel {
     } pending, current;
 
     bool configured;
+
+    // Buffer extent reported before the first configure, checked against it.
+    struct wlf_extent predicted;
+
+    // Reallocates the stretched buffer once an interactive resize goes idle.
+    struct wlf_source *resize_timer;
+
+    // Picks the render scale of fixed buffer extent toplevels.
+    struct wlf_governor governor;
+    int64_t target_frame_time;
+
+    bool placeholder;
+    bool placeholder_pending;
+    uint32_t placeholder_serial;
+    struct wlf_color placeholder_color;
 };
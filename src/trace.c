@@ -0,0 +1,171 @@
+#include <string.h>
+
+#include <wayland-client-protocol.h>
+
+#include "common_priv.h"
+#include "context_priv.h"
+#include "trace_priv.h"
+#include "log_priv.h"
+
+static const char *const wlf_timing_names[WLF_TIMING_COUNT] = {
+    [WLF_TIMING_CONNECT]         = "connect",
+    [WLF_TIMING_REGISTRY]        = "registry",
+    [WLF_TIMING_BIND]            = "bind",
+    [WLF_TIMING_CURSOR_THEME]    = "cursor theme",
+    [WLF_TIMING_KEYMAP]          = "keymap",
+    [WLF_TIMING_FIRST_CONFIGURE] = "first configure",
+    [WLF_TIMING_FIRST_FRAME]     = "first frame",
+};
+
+static const char *const wlf_counter_names[WLF_COUNTER_COUNT] = {
+    [WLF_COUNTER_FIRST_FRAME_CONFIGURES] = "first frame configures",
+    [WLF_COUNTER_PREDICTION_HITS]        = "prediction hits",
+    [WLF_COUNTER_PREDICTION_MISSES]      = "prediction misses",
+};
+
+const char *
+wlf_timing_get_name(enum wlf_timing timing)
+{
+    if (timing >= WLF_TIMING_COUNT) {
+        return nullptr;
+    }
+    return wlf_timing_names[timing];
+}
+
+const char *
+wlf_counter_get_name(enum wlf_counter counter)
+{
+    if (counter >= WLF_COUNTER_COUNT) {
+        return nullptr;
+    }
+    return wlf_counter_names[counter];
+}
+
+#ifdef WLF_TRACE
+
+// Spans past this point only record their first occurrence.
+static inline bool
+wlf_timing_is_once(enum wlf_timing timing)
+{
+    return timing >= WLF_TIMING_FIRST_CONFIGURE;
+}
+
+void
+wlf_trace_init(struct wlf_trace *trace, bool log)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->origin = wlf_get_time_ns();
+    trace->log = log;
+}
+
+void
+wlf_trace_fini(struct wlf_trace *trace)
+{
+    if (trace->first_frame_callback) {
+        wl_callback_destroy(trace->first_frame_callback);
+        trace->first_frame_callback = nullptr;
+    }
+}
+
+void
+wlf_trace_span_begin(struct wlf_trace *trace, enum wlf_timing timing)
+{
+    struct wlf_timing_span *span = &trace->spans[timing];
+    if (wlf_timing_is_once(timing) && span->start != 0) {
+        return;
+    }
+    span->start = wlf_get_time_ns();
+}
+
+void
+wlf_trace_span_end(struct wlf_trace *trace, enum wlf_timing timing)
+{
+    struct wlf_timing_span *span = &trace->spans[timing];
+    if (span->start == 0 || (wlf_timing_is_once(timing) && span->count > 0)) {
+        return;
+    }
+
+    int64_t duration = wlf_get_time_ns() - span->start;
+    span->duration += duration;
+    span->count++;
+
+    if (trace->log) {
+        wlf_info("Timing: %s took %.3f ms (%.3f ms since start).\n",
+            wlf_timing_names[timing],
+            (double)duration / 1e6,
+            (double)(span->start + duration - trace->origin) / 1e6);
+    }
+}
+
+// Each configure the application sees before its first frame is shown may
+// cost a buffer allocation, so a cold start should count exactly one.
+void
+wlf_trace_first_frame_configure(struct wlf_trace *trace)
+{
+    if (trace->spans[WLF_TIMING_FIRST_FRAME].count > 0) {
+        return;
+    }
+
+    trace->counters[WLF_COUNTER_FIRST_FRAME_CONFIGURES]++;
+    if (trace->log && trace->counters[WLF_COUNTER_FIRST_FRAME_CONFIGURES] > 1) {
+        wlf_info("Timing: configure %llu before the first frame.\n",
+            (unsigned long long)trace->counters[WLF_COUNTER_FIRST_FRAME_CONFIGURES]);
+    }
+}
+
+// region WL Callback
+
+static void
+wl_first_frame_done(void *data, struct wl_callback *wl_callback, uint32_t)
+{
+    struct wlf_trace *trace = data;
+
+    wl_callback_destroy(wl_callback);
+    trace->first_frame_callback = nullptr;
+    wlf_trace_span_end(trace, WLF_TIMING_FIRST_FRAME);
+}
+
+static const struct wl_callback_listener wl_first_frame_listener = {
+    .done = wl_first_frame_done,
+};
+
+// endregion
+
+// The frame callback is committed together with the first buffer the
+// application attaches, so its done event marks the first shown frame.
+void
+wlf_trace_first_frame(struct wlf_trace *trace, struct wl_surface *surface)
+{
+    if (trace->first_frame_callback || trace->spans[WLF_TIMING_FIRST_FRAME].count > 0) {
+        return;
+    }
+
+    trace->first_frame_callback = wl_surface_frame(surface);
+    if (trace->first_frame_callback) {
+        wl_callback_add_listener(
+            trace->first_frame_callback,
+            &wl_first_frame_listener,
+            trace);
+    }
+}
+
+#endif
+
+// region Public API
+
+enum wlf_result
+wlf_context_get_timing_report(
+    [[maybe_unused]] struct wlf_context *context,
+    [[maybe_unused]] struct wlf_timing_report *report)
+{
+#ifdef WLF_TRACE
+    report->origin = context->trace.origin;
+    memcpy(report->spans, context->trace.spans, sizeof(report->spans));
+    memcpy(report->counters, context->trace.counters, sizeof(report->counters));
+    return WLF_SUCCESS;
+#else
+    return WLF_ERROR_UNSUPPORTED;
+#endif
+}
+
+// endregion
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "wlf/timing.h"
+
+struct wl_callback;
+struct wl_surface;
+
+struct wlf_trace {
+    int64_t origin;
+    bool log;
+    struct wlf_timing_span spans[WLF_TIMING_COUNT];
+    uint64_t counters[WLF_COUNTER_COUNT];
+    struct wl_callback *first_frame_callback;
+};
+
+#ifdef WLF_TRACE
+
+void
+wlf_trace_init(struct wlf_trace *trace, bool log);
+
+void
+wlf_trace_fini(struct wlf_trace *trace);
+
+void
+wlf_trace_span_begin(struct wlf_trace *trace, enum wlf_timing timing);
+
+void
+wlf_trace_span_end(struct wlf_trace *trace, enum wlf_timing timing);
+
+void
+wlf_trace_first_frame(struct wlf_trace *trace, struct wl_surface *surface);
+
+void
+wlf_trace_first_frame_configure(struct wlf_trace *trace);
+
+#define wlf_trace_begin(context, timing) wlf_trace_span_begin(&(context)->trace, timing)
+#define wlf_trace_end(context, timing) wlf_trace_span_end(&(context)->trace, timing)
+#define wlf_trace_frame(context, surface) wlf_trace_first_frame(&(context)->trace, surface)
+#define wlf_trace_configure(context) wlf_trace_first_frame_configure(&(context)->trace)
+#define wlf_trace_count(context, counter) ((void)(context)->trace.counters[counter]++)
+
+#else
+
+#define wlf_trace_begin(context, timing) ((void)0)
+#define wlf_trace_end(context, timing) ((void)0)
+#define wlf_trace_frame(context, surface) ((void)0)
+#define wlf_trace_configure(context) ((void)0)
+#define wlf_trace_count(context, counter) ((void)0)
+
+#endif